@@ -1,126 +1,335 @@
 #pragma once
 
 #include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "ContainerStats.h"
+#include "InlineBuffer.h"
+#include "ResizePolicy.h"
 
 using std::cout;
 using std::endl;
 
 // ABQ class is a dynamic array that functions as a queue data structure.
-template <typename T>
-class ABQ                                       // Array-based queue
+template <typename T, typename Allocator = std::allocator<T>, unsigned int N = 0>
+class ABQ : private InlineBuffer<T, N>, private StatsRecorder // Array-based queue
 {
 private:
     // Member variables
-    T* _data;                                   // Data stored in the queue
+    T* _data;                                   // Data stored in the queue (only the _size slots from _location are constructed)
     unsigned int _size;                         // Current size of the queue
     unsigned int _capacity;                     // Current max capacity of the queue
-    unsigned int _location;                     // Track the first position of the queue
+    unsigned int _location;                     // Track the first position of the queue (head of the ring)
 
     // Class variable
-    float SCALE_FACTOR = 2.0f;                  // Scale factor for adjusting _capacity
+    ResizePolicy _policy;                       // When and by how much to adjust _capacity
+    unsigned int _reserved = 0;                 // Capacity floor set by reserve(), kept apart from _policy
+    Allocator _allocator;                       // Source of memory for _data
+
+    using AllocTraits = std::allocator_traits<Allocator>;
     
     // Private behaviors
     void shrink_capacity();                     // Reduce the capacity of the dynamic array
-    void increase_capacity();                   // Increase capacity of dynamic array
-    void add(T object);                         // Add a new object to the dynamic array
+    unsigned int min_capacity() const;          // Larger of _policy.min_capacity and _reserved
+    void increase_capacity(unsigned int count = 1); // Increase capacity to fit count more objects
+    void add(const T& object);                  // Copy a new object into the dynamic array
+    void add(T&& object);                       // Move a new object into the dynamic array
     void copy_from_object(const ABQ& object);   // Tool for copy constructor and copy assignment
-    unsigned int inc_location();                // Increment the first first position of the queue
+    void move_from_object(ABQ& object);         // Tool for move constructor and move assignment
+    void resize(unsigned int capacity);         // Reallocate _data and unwrap the ring into it
+    void release();                             // Destroy all objects and free _data
+    T* allocate(unsigned int capacity);         // Allocate uninitialized storage for capacity objects
+    static unsigned int storage_capacity(unsigned int capacity); // Capacity actually provided for a request
+    void deallocate(T* data, unsigned int capacity); // Free storage from allocate()
+    unsigned int wrap(unsigned int index) const; // Map a logical queue index to a slot in _data
+    unsigned int inc_location();                // Advance the first position of the queue around the ring
 
     public:
     // Constructors
     ABQ();                                      // Default constructor
     ABQ(unsigned int capacity);                 // Constructor with specified capacity
+    ABQ(unsigned int capacity, const ResizePolicy& policy); // Constructor with capacity and resize policy
+    explicit ABQ(const Allocator& allocator);   // Constructor with allocator
+    ABQ(unsigned int capacity, const ResizePolicy& policy, const Allocator& allocator); // Constructor with capacity, resize policy and allocator
     ABQ(const ABQ& rhs);                        // Copy constructor
+    ABQ(ABQ&& rhs) noexcept(N == 0 || std::is_nothrow_move_constructible<T>::value); // Move constructor
 
     ABQ& operator=(const ABQ& rhs);             // Copy assignment operator
+    ABQ& operator=(ABQ&& rhs) noexcept((AllocTraits::propagate_on_container_move_assignment::value
+        || AllocTraits::is_always_equal::value)
+        && (N == 0 || std::is_nothrow_move_constructible<T>::value)); // Move assignment operator
     
     ~ABQ();                                     // Destructor
 
     // Behaviors
-    void enqueue(T data);                       // Add to queue
+    void enqueue(const T& data);                // Copy onto queue
+    void enqueue(T&& data);                     // Move onto queue
+    template <typename... Args>
+    void emplace(Args&&... args);               // Construct a new object on the queue from args
     T dequeue();                                // Remove and return last item in queue
+    void enqueue_n(const T* data, unsigned int count); // Copy count objects into queue in one step
+    unsigned int dequeue_n(T* data, unsigned int count); // Move up to count objects out of queue in one step
+    void reserve(unsigned int capacity);        // Grow to at least capacity and never shrink below it
+    void shrink_to_fit();                       // Shrink _capacity to _size and drop the reserve() floor
+    void clear();                               // Remove every object but keep _capacity
     
     // Accessors
     T peek() const;                             // Return last item in queue
     unsigned int getSize() const;               // _size getter
     unsigned int getMaxCapacity() const;        // _capacity getter
     T* getData() const;                         // _data getter
+    const ResizePolicy& getResizePolicy() const; // _policy getter
+    Allocator getAllocator() const;             // _allocator getter
+    ContainerStats getStats() const;            // Counters recorded under CONTAINER_STATS
+
+    // Mutators
+    void setResizePolicy(const ResizePolicy& policy); // _policy setter
+    void resetStats();                          // Zero the counters from getStats()
 
     // Debug
     void print();                               // Debug tool that prints all member variables.
 };
 
+// ABQ that keeps its first N objects inside the object itself, e.g. SmallABQ<int, 16>
+template <typename T, unsigned int N>
+using SmallABQ = ABQ<T, std::allocator<T>, N>;
+
+/*
+* Shrinks _capacity if _policy says the queue has become sparse enough.
+* By default that is (size / capacity < 1/4), which leaves a gap below the
+* growth point so a queue hovering around a power of two does not thrash.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::shrink_capacity()
+{
+    if (_capacity <= _reserved || !_policy.should_shrink(_size, _capacity))
+        return;
+
+    unsigned int capacity = _policy.shrink(_size, _capacity);
+    resize(capacity > _reserved ? capacity : _reserved);
+}
+
 /*
-* Shrinks _capacity if (size / capacity < 1 / SCALE_FACTOR).
+* Returns:
+* The capacity the queue never shrinks below: the floor of _policy or the one
+* set by reserve(), whichever is larger.
 */
-template <typename T>
-void ABQ<T>::shrink_capacity()
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::min_capacity() const
 {
-    float size = getSize();
-    float capacity = getMaxCapacity();
+    return _policy.min_capacity > _reserved ? _policy.min_capacity : _reserved;
+}
+
+/*
+* Increases _capacity if (_size + count > _capacity).
+* Grows by _policy as many times as needed, but reallocates only once.
+*
+* Parameter:
+* - count: Number of objects about to be added.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::increase_capacity(unsigned int count)
+{
+    if (count <= _capacity - _size)
+        return;
+
+    unsigned int capacity = _capacity;
+    while (count > capacity - _size)
+        capacity = _policy.grow(capacity);
 
-    if (size / capacity < 1 / SCALE_FACTOR)
-    {  
-        _capacity = _capacity / SCALE_FACTOR;
-        // Allocate memory for new array to store transferred objects
-        T *resized_data = new T[_capacity + 1];
-        
-        // Transfer objects from old array to new array according to _size
-        for (unsigned int i = 0; i < _size + 1; i++)
+    resize(capacity);
+}
+
+/*
+* Helper function.
+* Allocates a new array and transfers the queue into it in order, so the
+* first object lands at index 0 and the ring is unwrapped.
+*
+* Parameter:
+* - capacity: Capacity of the new array. Must be at least _size.
+*
+* Dependencies:
+* - shrink_capacity()
+* - increase_capacity()
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::resize(unsigned int capacity)
+{
+    capacity = storage_capacity(capacity);
+
+    // Already in the inline buffer and staying there
+    if (_data == this->inline_data() && capacity == _capacity)
+        return;
+
+    // Allocate uninitialized memory for new array to store transferred objects
+    T *resized_data = allocate(capacity);
+
+    // Transfer objects from old array to new array according to _size.
+    // Trivially copyable objects are copied as the (at most) two contiguous
+    // runs of the ring; others are move constructed into place one at a time
+    // and then destroyed in the old array.
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        unsigned int first_run = _capacity - _location;
+        if (first_run > _size)
+            first_run = _size;
+
+        if (first_run > 0)
+            std::memcpy(resized_data, _data + _location, first_run * sizeof(T));
+        if (_size > first_run)
+            std::memcpy(resized_data + first_run, _data, (_size - first_run) * sizeof(T));
+    }
+    else
+    {
+        unsigned int i = 0;
+        try
+        {
+            for (; i < _size; i++)
+                AllocTraits::construct(_allocator, resized_data + i, std::move_if_noexcept(_data[wrap(i)]));
+        }
+        catch (...)
         {
-            // _data[_location] will give the position of the first object in queue
-            resized_data[i] = _data[i + _location];
+            // Leave the queue untouched if a transfer fails
+            while (i > 0)
+                AllocTraits::destroy(_allocator, &resized_data[--i]);
+            deallocate(resized_data, capacity);
+            throw;
         }
-        
-        // Delete old array
-        delete[] _data;
-        // Assign _data to new array.
-        _data = resized_data;
-        // Reset the tracked position of the queue
-        _location = 0; 
+
+        for (i = 0; i < _size; i++)
+            AllocTraits::destroy(_allocator, &_data[wrap(i)]);
     }
+
+    this->record_resize(capacity > _capacity, (unsigned long long)_size * sizeof(T));
+
+    // Free old array
+    deallocate(_data, _capacity);
+    // Assign _data to new array.
+    _data = resized_data;
+    _capacity = capacity;
+    // Reset the tracked position of the queue
+    _location = 0;
 }
 
 /*
-* Increases _capacity if (_size == _capacity).
+* Helper function.
+* Destroys every object in the queue and frees _data.
+*
+* Dependencies:
+* - copy assignment operator
+* - move assignment operator
+* - destructor
 */
-template <typename T>
-void ABQ<T>::increase_capacity()
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::release()
 {
-    if (_size == _capacity)
+    if constexpr (!std::is_trivially_destructible<T>::value)
     {
-        _capacity = _capacity * SCALE_FACTOR;
-        // Allocate memory for new array to store transferred objects
-        T *resized_data = new T[_capacity];
-        
-        // Transfer objects from old array to new array according to _size
         for (unsigned int i = 0; i < _size; i++)
-        {
-            // _data[_location] will give the position of the first object in queue
-            resized_data[i] = _data[i + _location];
-        }
-
-        // Delete old array
-        delete[] _data;
-        // Assign _data to new array.
-        _data = resized_data;
-        // Reset the tracked position of the queue
-        _location = 0; 
+            AllocTraits::destroy(_allocator, &_data[wrap(i)]);
     }
+
+    deallocate(_data, _capacity);
+    _data = nullptr;
+    _size = 0;
+    _capacity = 0;
+    _location = 0;
+}
+
+/*
+* Helper function.
+* Allocates storage for capacity objects without constructing any of them.
+* Requests of up to N objects are served from the inline buffer.
+*
+* Parameter:
+* - capacity: Number of objects the storage must hold.
+*/
+template <typename T, typename Allocator, unsigned int N>
+T* ABQ<T, Allocator, N>::allocate(unsigned int capacity)
+{
+    if (capacity <= N)
+        return this->inline_data();
+
+    return AllocTraits::allocate(_allocator, capacity);
+}
+
+/*
+* Helper function.
+* Requests that fit in the inline buffer are given all N inline slots.
+*
+* Parameter:
+* - capacity: Requested capacity.
+*
+* Returns:
+* max(capacity, N).
+*/
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::storage_capacity(unsigned int capacity)
+{
+    return capacity > N ? capacity : N;
+}
+
+/*
+* Helper function.
+* Frees storage returned by allocate(). Objects must already be destroyed.
+*
+* Parameters:
+* - data: Storage to free. May be nullptr or the inline buffer.
+* - capacity: Capacity the storage was allocated with.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::deallocate(T* data, unsigned int capacity)
+{
+    if (data && data != this->inline_data())
+        AllocTraits::deallocate(_allocator, data, capacity);
+}
+
+/*
+* Helper function.
+* Maps a position counted from the front of the queue onto _data, wrapping
+* around the end of the array.
+*
+* Parameter:
+* - index: Position relative to the first object in the queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::wrap(unsigned int index) const
+{
+    index += _location;
+    return index < _capacity ? index : index - _capacity;
 }
 
 /*
 * Helper function.
 * Adds new object to end of queue and increases size.
+* The end of the queue is the slot _size positions past _location.
 *
 * Dependencies:
 * - copy_from_object()
 * - enqueue()
 */
-template <typename T>
-void ABQ<T>::add(T object)
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::add(const T& object)
 {
-    _data[_size] = object;
+    AllocTraits::construct(_allocator, _data + wrap(_size), object);
+    _size++;
+}
+
+/*
+* Helper function.
+* Moves new object to end of queue and increases size.
+*
+* Dependencies:
+* - emplace()
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::add(T&& object)
+{
+    AllocTraits::construct(_allocator, _data + wrap(_size), std::move(object));
     _size++;
 }
 
@@ -135,41 +344,92 @@ void ABQ<T>::add(T object)
 * - copy constructor
 * - copy assignment operator
 */
-template <typename T>
-void ABQ<T>::copy_from_object(const ABQ& object)
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::copy_from_object(const ABQ& object)
 {
+    _size = 0;
+    _capacity = object._capacity;
+    _location = 0;
+    _policy = object._policy;
+    _reserved = object._reserved;
+    _data = allocate(_capacity);
+
+    for (unsigned int i = 0; i < object._size; i++)
+        add(object._data[object.wrap(i)]);
+}
+
+/*
+* Helper function.
+* Takes ownership of another queue's dynamic memory and leaves it empty with
+* only its inline capacity. If the objects are in the other queue's inline
+* buffer they are moved individually instead. The emptied queue is still valid
+* and grows on its next enqueue.
+*
+* Parameter:
+* - object: Queue object (rhs) to be moved into another queue object.
+*
+* Dependencies:
+* - move constructor
+* - move assignment operator
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::move_from_object(ABQ& object)
+{
+    _policy = object._policy;
+    _reserved = object._reserved;
+    object._reserved = 0;
+
+    // Objects in the inline buffer cannot change owner, so move them one by one
+    if (N > 0 && object._data == object.inline_data())
+    {
+        _data = this->inline_data();
+        _size = 0;
+        _capacity = N;
+        _location = 0;
+
+        for (unsigned int i = 0; i < object._size; i++)
+            add(std::move(object._data[object.wrap(i)]));
+        object.clear();
+        return;
+    }
+
+    _data = object._data;
     _size = object._size;
     _capacity = object._capacity;
     _location = object._location;
-    _data = new T[_capacity];
 
-    for (unsigned int i = 0; i < object._size; i++)
-        add(object[i]);
+    object._data = object.allocate(0);
+    object._size = 0;
+    object._capacity = storage_capacity(0);
+    object._location = 0;
 }
 
 /*
 * Helper function.
-* Increments _location and returns (_location - 1). 
+* Advances _location to the next slot, wrapping to 0 at the end of the
+* array, and returns the previous _location.
+*
 * Dependencies:
 * - dequeue()
 */
-template <typename T> 
-unsigned int ABQ<T>::inc_location()
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::inc_location()
 {
-    _location++;
-    return _location - 1;
+    unsigned int location = _location;
+    _location = wrap(1);
+    return location;
 }
 
 /*
 * Default constructor.
 */
-template <typename T>
-ABQ<T>::ABQ()
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ()
 {
     _size = 0;
-    _capacity = 1;
+    _capacity = storage_capacity(1);
     _location = 0;
-    _data = new T[_capacity];
+    _data = allocate(_capacity);
 }
 
 /*
@@ -178,57 +438,224 @@ ABQ<T>::ABQ()
 * Parameter:
 * - capacity: Value to which _capacity will be set for new queue.
 */
-template <typename T>
-ABQ<T>::ABQ(unsigned int capacity)
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ(unsigned int capacity)
 {
     _size = 0;
-    _capacity = capacity;
+    _capacity = storage_capacity(capacity);
+    _location = 0;
+    _data = allocate(_capacity);
+}
+
+/*
+* Constructor with assignment to _capacity and _policy.
+*
+* Parameters:
+* - capacity: Value to which _capacity will be set for new queue.
+* - policy: Growth and shrink policy for new queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ(unsigned int capacity, const ResizePolicy& policy)
+{
+    _size = 0;
+    _capacity = storage_capacity(capacity);
     _location = 0;
-    _data = new T[_capacity];
+    _policy = policy;
+    _data = allocate(_capacity);
+}
+
+/*
+* Constructor with assignment to _allocator. Starts with a capacity of 1 like
+* the default constructor.
+*
+* Parameter:
+* - allocator: Allocator that provides memory for new queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ(const Allocator& allocator)
+    : ABQ(1, ResizePolicy(), allocator)
+{
+}
+
+/*
+* Constructor with assignment to _capacity, _policy and _allocator.
+*
+* Parameters:
+* - capacity: Value to which _capacity will be set for new queue.
+* - policy: Growth and shrink policy for new queue.
+* - allocator: Allocator that provides memory for new queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ(unsigned int capacity, const ResizePolicy& policy, const Allocator& allocator)
+    : _allocator(allocator)
+{
+    _size = 0;
+    _capacity = storage_capacity(capacity);
+    _location = 0;
+    _policy = policy;
+    _data = allocate(_capacity);
 }
 
 /*
 * Copy constructor.
+* The new queue gets the allocator chosen by
+* allocator_traits::select_on_container_copy_construction().
 */
-template <typename T>
-ABQ<T>::ABQ(const ABQ& rhs)
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ(const ABQ& rhs)
+    : _allocator(AllocTraits::select_on_container_copy_construction(rhs._allocator))
 {
     copy_from_object(rhs);
 }
 
+/*
+* Move constructor.
+* The allocator is copied, so memory taken from rhs is freed by an equal one.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::ABQ(ABQ&& rhs) noexcept(N == 0 || std::is_nothrow_move_constructible<T>::value)
+    : _allocator(rhs._allocator)
+{
+    move_from_object(rhs);
+}
+
 /*
 * Copy assignment operator.
 */
-template <typename T>
-ABQ<T>& ABQ<T>::operator=(const ABQ<T>& rhs)
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>& ABQ<T, Allocator, N>::operator=(const ABQ<T, Allocator, N>& rhs)
 {
-    delete[] _data;
+    if (this == &rhs)
+        return *this;
+
+    release();
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value)
+        _allocator = rhs._allocator;
     copy_from_object(rhs);
 
     return *this;
 }
 
+/*
+* Move assignment operator.
+* rhs's memory is taken over only if the allocator propagates or the two
+* allocators are equal. Otherwise the objects are moved one by one into
+* memory from this queue's own allocator.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>& ABQ<T, Allocator, N>::operator=(ABQ<T, Allocator, N>&& rhs)
+    noexcept((AllocTraits::propagate_on_container_move_assignment::value
+        || AllocTraits::is_always_equal::value)
+        && (N == 0 || std::is_nothrow_move_constructible<T>::value))
+{
+    if (this == &rhs)
+        return *this;
+
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value)
+    {
+        release();
+        _allocator = rhs._allocator;
+        move_from_object(rhs);
+    }
+    else if (_allocator == rhs._allocator)
+    {
+        release();
+        move_from_object(rhs);
+    }
+    else
+    {
+        // Fill new storage before freeing the old one, so a failed allocation
+        // or transfer leaves this queue as it was. The inline buffer may still
+        // hold this queue's objects, so it is not used as the new storage.
+        unsigned int capacity = storage_capacity(rhs._size);
+        T* moved_data = _data == this->inline_data() ? AllocTraits::allocate(_allocator, capacity) : allocate(capacity);
+        unsigned int i = 0;
+
+        try
+        {
+            for (; i < rhs._size; i++)
+                AllocTraits::construct(_allocator, moved_data + i, std::move_if_noexcept(rhs._data[rhs.wrap(i)]));
+        }
+        catch (...)
+        {
+            while (i > 0)
+                AllocTraits::destroy(_allocator, &moved_data[--i]);
+            deallocate(moved_data, capacity);
+            throw;
+        }
+
+        release();
+        _data = moved_data;
+        _size = rhs._size;
+        _capacity = capacity;
+        _policy = rhs._policy;
+        _reserved = 0;
+        rhs.clear();
+    }
+
+    return *this;
+}
+
 /*
 * Destructor.
 */
-template <typename T>
-ABQ<T>::~ABQ()
+template <typename T, typename Allocator, unsigned int N>
+ABQ<T, Allocator, N>::~ABQ()
 {
-    delete[] _data;
+    release();
 }
 
 /*
-* Add a new object to the queue.
+* Copy a new object into the queue.
 * If necessary, resize the queue to make room for new object.
-
-Parameter:
+*
+* Parameter:
 * - data: Object to be added to the end of queue.
 */
-template <typename T>
-void ABQ<T>::enqueue(T data)
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::enqueue(const T& data)
 {
-    increase_capacity();
-    add(data);
+    emplace(data);
+}
+
+/*
+* Move a new object into the queue.
+* If necessary, resize the queue to make room for new object.
+*
+* Parameter:
+* - data: Object to be moved to the end of queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::enqueue(T&& data)
+{
+    emplace(std::move(data));
+}
+
+/*
+* Construct a new object at the end of the queue from the given arguments.
+* When there is room the object is constructed directly in _data. Otherwise
+* it is built before the resize, so args may refer to objects that are
+* already in the queue.
+*
+* Parameter:
+* - args: Arguments forwarded to a constructor of T.
+*/
+template <typename T, typename Allocator, unsigned int N>
+template <typename... Args>
+void ABQ<T, Allocator, N>::emplace(Args&&... args)
+{
+    if (_size == _capacity)
+    {
+        T object(std::forward<Args>(args)...);
+        increase_capacity();
+        add(std::move(object));
+        this->record_push(1, _size);
+        return;
+    }
+
+    AllocTraits::construct(_allocator, _data + wrap(_size), std::forward<Args>(args)...);
+    _size++;
+    this->record_push(1, _size);
 }
 
 /*
@@ -238,22 +665,163 @@ void ABQ<T>::enqueue(T data)
 * Returns:
 * Removed object.
 */
-template <typename T>
-T ABQ<T>::dequeue()
+template <typename T, typename Allocator, unsigned int N>
+T ABQ<T, Allocator, N>::dequeue()
 {
     if (_size == 0)
         throw std::runtime_error("Queue is empty.");
 
+    unsigned int location = inc_location();
+    T data = std::move(_data[location]);
+    AllocTraits::destroy(_allocator, &_data[location]);
     _size--;
+    this->record_pop(1);
+    shrink_capacity();
+    return data;
+}
+
+/*
+* Copy an array of objects into the queue, in order. Capacity is increased at
+* most once for the whole array, and trivially copyable objects are copied
+* with at most two memcpy calls (one per side of the ring's wraparound).
+*
+* Parameters:
+* - data: First object to be added. Must not point into this queue.
+* - count: Number of objects to add.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::enqueue_n(const T* data, unsigned int count)
+{
+    increase_capacity(count);
+
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        if (count == 0)
+            return;
+
+        unsigned int end = wrap(_size);
+        unsigned int first_run = _capacity - end;
+        if (first_run > count)
+            first_run = count;
+
+        std::memcpy(_data + end, data, first_run * sizeof(T));
+        if (count > first_run)
+            std::memcpy(_data, data + first_run, (count - first_run) * sizeof(T));
+        _size += count;
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; i++)
+            add(data[i]);
+    }
+
+    this->record_push(count, _size);
+}
+
+/*
+* Remove objects from the front of the queue in one step, in queue order.
+* The queue is shrunk at most once.
+*
+* Parameters:
+* - data: Array of at least count objects that receives the removed objects.
+* - count: Maximum number of objects to remove.
+*
+* Returns:
+* Number of objects removed, min(count, getSize()).
+*/
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::dequeue_n(T* data, unsigned int count)
+{
+    if (count > _size)
+        count = _size;
+
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        unsigned int first_run = _capacity - _location;
+        if (first_run > count)
+            first_run = count;
+
+        if (first_run > 0)
+            std::memcpy(data, _data + _location, first_run * sizeof(T));
+        if (count > first_run)
+            std::memcpy(data + first_run, _data, (count - first_run) * sizeof(T));
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            data[i] = std::move(_data[wrap(i)]);
+            AllocTraits::destroy(_allocator, &_data[wrap(i)]);
+        }
+    }
+
+    if (count > 0)
+    {
+        _location = wrap(count % _capacity);
+        _size -= count;
+    }
+
+    this->record_pop(count);
     shrink_capacity();
-    return _data[inc_location()];
+    return count;
+}
+
+/*
+* Make room for at least capacity objects now, so later insertions up to that
+* size never reallocate. The reserved capacity also becomes a floor for
+* automatic shrinking, kept apart from the ResizePolicy, so draining the
+* queue does not give the memory back either.
+*
+* Parameter:
+* - capacity: Number of objects the queue must hold without reallocating.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::reserve(unsigned int capacity)
+{
+    if (capacity > _capacity)
+        resize(capacity);
+
+    if (capacity > _reserved)
+        _reserved = capacity;
+}
+
+/*
+* Drop the floor set by reserve(), so automatic shrinking applies again, and
+* reallocate _data to hold just the current objects, but never less than
+* _policy.min_capacity.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::shrink_to_fit()
+{
+    _reserved = 0;
+
+    unsigned int capacity = _size > min_capacity() ? _size : min_capacity();
+    if (capacity < _capacity)
+        resize(capacity);
+}
+
+/*
+* Destroy every object in the queue. _capacity is kept so the queue can be
+* refilled without reallocating.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::clear()
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        for (unsigned int i = 0; i < _size; i++)
+            AllocTraits::destroy(_allocator, &_data[wrap(i)]);
+    }
+
+    _size = 0;
+    _location = 0;
 }
 
 /*
 * View the first object in the queue.
 */
-template <typename T>
-T ABQ<T>::peek() const
+template <typename T, typename Allocator, unsigned int N>
+T ABQ<T, Allocator, N>::peek() const
 {
     if (_size == 0)
     throw std::runtime_error("Queue is empty.");
@@ -265,8 +833,8 @@ T ABQ<T>::peek() const
 * Returns:
 * Current size of the queue.
 */
-template <typename T>
-unsigned int ABQ<T>::getSize() const
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::getSize() const
 {
     return _size;
 }
@@ -275,8 +843,8 @@ unsigned int ABQ<T>::getSize() const
 * Returns:
 * Current capacity of the queue.
 */
-template <typename T>
-unsigned int ABQ<T>::getMaxCapacity() const
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABQ<T, Allocator, N>::getMaxCapacity() const
 {
     return _capacity;
 }
@@ -285,23 +853,76 @@ unsigned int ABQ<T>::getMaxCapacity() const
 * Returns:
 * Queue's dynamic array.
 */
-template <typename T>
-T* ABQ<T>::getData() const
+template <typename T, typename Allocator, unsigned int N>
+T* ABQ<T, Allocator, N>::getData() const
     {
         return _data;
     }
 
+/*
+* Returns:
+* Growth and shrink policy of the queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+const ResizePolicy& ABQ<T, Allocator, N>::getResizePolicy() const
+{
+    return _policy;
+}
+
+/*
+* Returns:
+* Copy of the allocator that provides memory for the queue.
+*/
+template <typename T, typename Allocator, unsigned int N>
+Allocator ABQ<T, Allocator, N>::getAllocator() const
+{
+    return _allocator;
+}
+
+/*
+* Returns:
+* Operation and resize counters for this queue. All zero unless compiled
+* with CONTAINER_STATS.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ContainerStats ABQ<T, Allocator, N>::getStats() const
+{
+    return this->stats();
+}
+
+/*
+* Replace the growth and shrink policy of the queue.
+* The new policy takes effect on the next enqueue or dequeue.
+*
+* Parameter:
+* - policy: New growth and shrink policy.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::setResizePolicy(const ResizePolicy& policy)
+{
+    _policy = policy;
+}
+
+/*
+* Zero every counter returned by getStats(), e.g. after a warm-up phase.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::resetStats()
+{
+    this->reset_stats();
+}
+
 /*
 * Debug tool for printing all member variables of a queue.
 */
-template <typename T> 
-void ABQ<T>::print()
+template <typename T, typename Allocator, unsigned int N>
+void ABQ<T, Allocator, N>::print()
 {
     cout << "_data contents: ";
-    for (unsigned int i = 0; i < _capacity; i++)
+    for (unsigned int i = 0; i < _size; i++)
     {
-        cout << _data[i] << " ";
+        cout << _data[wrap(i)] << " ";
     }
     cout << endl;
-    cout << "_capacity: " << _capacity << ", _size: " << _size << ", next dequeue: " << _data[_location] << endl;
+    cout << "_capacity: " << _capacity << ", _size: " << _size << ", _location: " << _location << endl;
 }
@@ -1,104 +1,277 @@
 #pragma once
 
 #include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "ContainerStats.h"
+#include "InlineBuffer.h"
+#include "ResizePolicy.h"
 
 using std::cout;
 using std::endl;
 
 //ABS class is a dynamic array implemented as a stack data structure
-template <typename T>
-class ABS                                       // Array-based stack
+template <typename T, typename Allocator = std::allocator<T>, unsigned int N = 0>
+class ABS : private InlineBuffer<T, N>, private StatsRecorder // Array-based stack
 {
 private:
     // Member variables
-    T* _data;                                   // Data stored in the stack
+    T* _data;                                   // Data stored in the stack (only [0, _size) is constructed)
     unsigned int _size;                         // Current size of the stack
     unsigned int _capacity;                     // Current max capacity of the stack
 
     // Class variable
-    float scale_factor = 2.0f;                  // Scale factor for adjusting _capacity
+    ResizePolicy _policy;                       // When and by how much to adjust _capacity
+    unsigned int _reserved = 0;                 // Capacity floor set by reserve(), kept apart from _policy
+    Allocator _allocator;                       // Source of memory for _data
+
+    using AllocTraits = std::allocator_traits<Allocator>;
     
     // Private behaviors
     void shrink_capacity();                     // Reduce the capacity of the dynamic array
-    void increase_capacity();                   // Increase capacity of dynamic array
-    void add(T object);                         // Add a new object to the dynamic array
+    unsigned int min_capacity() const;          // Larger of _policy.min_capacity and _reserved
+    void increase_capacity(unsigned int count = 1); // Increase capacity to fit count more objects
+    void add(const T& object);                  // Copy a new object into the dynamic array
+    void add(T&& object);                       // Move a new object into the dynamic array
     void copy_from_object(const ABS& object);   // Tool for copy constructor and copy assignment
+    void move_from_object(ABS& object);         // Tool for move constructor and move assignment
+    void resize(unsigned int capacity);         // Reallocate _data with a new capacity
+    void release();                             // Destroy all objects and free _data
+    T* allocate(unsigned int capacity);         // Allocate uninitialized storage for capacity objects
+    static unsigned int storage_capacity(unsigned int capacity); // Capacity actually provided for a request
+    void deallocate(T* data, unsigned int capacity); // Free storage from allocate()
 
 public:
     // Constructors
     ABS();                                      // Default constructor
     ABS(unsigned int capacity);                 // Constructor with specified capacity
+    ABS(unsigned int capacity, const ResizePolicy& policy); // Constructor with capacity and resize policy
+    explicit ABS(const Allocator& allocator);   // Constructor with allocator
+    ABS(unsigned int capacity, const ResizePolicy& policy, const Allocator& allocator); // Constructor with capacity, resize policy and allocator
     ABS(const ABS& rhs);                        // Copy constructor
+    ABS(ABS&& rhs) noexcept(N == 0 || std::is_nothrow_move_constructible<T>::value); // Move constructor
 
     ABS& operator=(const ABS& rhs);             // Copy assignment operator
+    ABS& operator=(ABS&& rhs) noexcept((AllocTraits::propagate_on_container_move_assignment::value
+        || AllocTraits::is_always_equal::value)
+        && (N == 0 || std::is_nothrow_move_constructible<T>::value)); // Move assignment operator
     
     ~ABS();                                     // Destructor
 
     // Behaviors
-    void push(T data);                          // Add to stack
+    void push(const T& data);                   // Copy onto stack
+    void push(T&& data);                        // Move onto stack
+    template <typename... Args>
+    void emplace(Args&&... args);               // Construct a new object on the stack from args
     T pop();                                    // Remove and return last item in stack
+    void push_range(const T* data, unsigned int count); // Copy count objects onto stack in one step
+    unsigned int pop_range(T* data, unsigned int count); // Move up to count objects off stack in one step
+    void reserve(unsigned int capacity);        // Grow to at least capacity and never shrink below it
+    void shrink_to_fit();                       // Shrink _capacity to _size and drop the reserve() floor
+    void clear();                               // Remove every object but keep _capacity
     
     // Accessors
     T peek() const;                             // Return last item in stack
     unsigned int getSize() const;               // _size getter
     unsigned int getMaxCapacity() const;        // _capacity getter
     T* getData() const;                         // _data getter
+    const ResizePolicy& getResizePolicy() const; // _policy getter
+    Allocator getAllocator() const;             // _allocator getter
+    ContainerStats getStats() const;            // Counters recorded under CONTAINER_STATS
+
+    // Mutators
+    void setResizePolicy(const ResizePolicy& policy); // _policy setter
+    void resetStats();                          // Zero the counters from getStats()
 
     // Debug
     void print();                               // Debug tool that prints all member variables
 };
 
+// ABS that keeps its first N objects inside the object itself, e.g. SmallABS<int, 16>
+template <typename T, unsigned int N>
+using SmallABS = ABS<T, std::allocator<T>, N>;
+
 /*
-* Shrinks _capacity if (size / capacity < 1 / SCALE_FACTOR).
+* Shrinks _capacity if _policy says the stack has become sparse enough.
+* By default that is (size / capacity < 1/4), which leaves a gap below the
+* growth point so a stack hovering around a power of two does not thrash.
 */
-template <typename T>
-void ABS<T>::shrink_capacity()
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::shrink_capacity()
 {
-    float size = getSize();
-    float capacity = getMaxCapacity();
+    if (_capacity <= _reserved || !_policy.should_shrink(_size, _capacity))
+        return;
 
-    if (size / capacity < 1 / scale_factor)
-    {  
-        // Allocate memory for new array to store transferred objects
-        _capacity = _capacity / scale_factor;
-        T *resized_data = new T[_capacity + 1];
+    unsigned int capacity = _policy.shrink(_size, _capacity);
+    resize(capacity > _reserved ? capacity : _reserved);
+}
 
-        // Transfer objects from old array to new array according to _size
-        for (unsigned int i = 0; i < _size + 1; i++)
-            {
-                resized_data[i] = _data[i];
-            }
-        
-        // Delete old array
-        delete[] _data;
-        // Assign _data to new array.
-        _data = resized_data; 
-    }
+/*
+* Returns:
+* The capacity the stack never shrinks below: the floor of _policy or the one
+* set by reserve(), whichever is larger.
+*/
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABS<T, Allocator, N>::min_capacity() const
+{
+    return _policy.min_capacity > _reserved ? _policy.min_capacity : _reserved;
 }
 
 /*
-* Increases _capacity if (_size == _capacity).
+* Increases _capacity if (_size + count > _capacity).
+* Grows by _policy as many times as needed, but reallocates only once.
+*
+* Parameter:
+* - count: Number of objects about to be added.
 */
-template <typename T>
-void ABS<T>::increase_capacity()
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::increase_capacity(unsigned int count)
 {
-    if (_size == _capacity)
+    if (count <= _capacity - _size)
+        return;
+
+    unsigned int capacity = _capacity;
+    while (count > capacity - _size)
+        capacity = _policy.grow(capacity);
+
+    resize(capacity);
+}
+
+/*
+* Helper function.
+* Allocates a new array and transfers the stack into it.
+*
+* Parameter:
+* - capacity: Capacity of the new array. Must be at least _size.
+*
+* Dependencies:
+* - shrink_capacity()
+* - increase_capacity()
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::resize(unsigned int capacity)
+{
+    capacity = storage_capacity(capacity);
+
+    // Already in the inline buffer and staying there
+    if (_data == this->inline_data() && capacity == _capacity)
+        return;
+
+    // Allocate uninitialized memory for new array to store transferred objects
+    T *resized_data = allocate(capacity);
+
+    // Transfer objects from old array to new array according to _size.
+    // Trivially copyable objects are copied in one block; others are move
+    // constructed into place and then destroyed in the old array.
+    if constexpr (std::is_trivially_copyable<T>::value)
     {
-        // Allocate memory for new array to store transferred objects
-        _capacity = _capacity * scale_factor;
-        T *resized_data = new T[_capacity];
+        if (_size > 0)
+            std::memcpy(resized_data, _data, _size * sizeof(T));
+    }
+    else
+    {
+        unsigned int i = 0;
+        try
+        {
+            for (; i < _size; i++)
+                AllocTraits::construct(_allocator, resized_data + i, std::move_if_noexcept(_data[i]));
+        }
+        catch (...)
+        {
+            // Leave the stack untouched if a transfer fails
+            while (i > 0)
+                AllocTraits::destroy(_allocator, &resized_data[--i]);
+            deallocate(resized_data, capacity);
+            throw;
+        }
+
+        for (i = 0; i < _size; i++)
+            AllocTraits::destroy(_allocator, &_data[i]);
+    }
+
+    this->record_resize(capacity > _capacity, (unsigned long long)_size * sizeof(T));
 
-        // Transfer objects from old array to new array according to _size
+    // Free old array
+    deallocate(_data, _capacity);
+    // Assign _data to new array.
+    _data = resized_data;
+    _capacity = capacity;
+}
+
+/*
+* Helper function.
+* Destroys every object in the stack and frees _data.
+*
+* Dependencies:
+* - copy assignment operator
+* - move assignment operator
+* - destructor
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::release()
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
         for (unsigned int i = 0; i < _size; i++)
-            {
-                resized_data[i] = _data[i];
-            }
-
-        // Delete old array
-        delete[] _data;
-        // Assign _data to new array.
-        _data = resized_data;
+            AllocTraits::destroy(_allocator, &_data[i]);
     }
+
+    deallocate(_data, _capacity);
+    _data = nullptr;
+    _size = 0;
+    _capacity = 0;
+}
+
+/*
+* Helper function.
+* Allocates storage for capacity objects without constructing any of them.
+* Requests of up to N objects are served from the inline buffer.
+*
+* Parameter:
+* - capacity: Number of objects the storage must hold.
+*/
+template <typename T, typename Allocator, unsigned int N>
+T* ABS<T, Allocator, N>::allocate(unsigned int capacity)
+{
+    if (capacity <= N)
+        return this->inline_data();
+
+    return AllocTraits::allocate(_allocator, capacity);
+}
+
+/*
+* Helper function.
+* Requests that fit in the inline buffer are given all N inline slots.
+*
+* Parameter:
+* - capacity: Requested capacity.
+*
+* Returns:
+* max(capacity, N).
+*/
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABS<T, Allocator, N>::storage_capacity(unsigned int capacity)
+{
+    return capacity > N ? capacity : N;
+}
+
+/*
+* Helper function.
+* Frees storage returned by allocate(). Objects must already be destroyed.
+*
+* Parameters:
+* - data: Storage to free. May be nullptr or the inline buffer.
+* - capacity: Capacity the storage was allocated with.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::deallocate(T* data, unsigned int capacity)
+{
+    if (data && data != this->inline_data())
+        AllocTraits::deallocate(_allocator, data, capacity);
 }
 
 /*
@@ -109,10 +282,24 @@ void ABS<T>::increase_capacity()
 * - copy_from_object()
 * - push()
 */
-template <typename T>
-void ABS<T>::add(T object)
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::add(const T& object)
 {
-    _data[_size] = object;
+    AllocTraits::construct(_allocator, _data + _size, object);
+    _size++;
+}
+
+/*
+* Helper function.
+* Moves new object to end of stack and increases size.
+*
+* Dependencies:
+* - emplace()
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::add(T&& object)
+{
+    AllocTraits::construct(_allocator, _data + _size, std::move(object));
     _size++;
 }
 
@@ -127,26 +314,71 @@ void ABS<T>::add(T object)
 * - copy constructor
 * - copy assignment operator
 */
-template <typename T>
-void ABS<T>::copy_from_object(const ABS& object)
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::copy_from_object(const ABS& object)
 {
-    _size = object._size;
+    _size = 0;
     _capacity = object._capacity;
-    _data = new T[_capacity];
+    _policy = object._policy;
+    _reserved = object._reserved;
+    _data = allocate(_capacity);
 
     for (unsigned int i = 0; i < object._size; i++)
-        add(object[i]);
+        add(object._data[i]);
+}
+
+/*
+* Helper function.
+* Takes ownership of another stack's dynamic memory and leaves it empty with
+* only its inline capacity. If the objects are in the other stack's inline
+* buffer they are moved individually instead. The emptied stack is still valid
+* and grows on its next push.
+*
+* Parameter:
+* - object: stack object (rhs) to be moved into another stack object.
+*
+* Dependencies:
+* - move constructor
+* - move assignment operator
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::move_from_object(ABS& object)
+{
+    _policy = object._policy;
+    _reserved = object._reserved;
+    object._reserved = 0;
+
+    // Objects in the inline buffer cannot change owner, so move them one by one
+    if (N > 0 && object._data == object.inline_data())
+    {
+        _data = this->inline_data();
+        _size = 0;
+        _capacity = N;
+
+        for (unsigned int i = 0; i < object._size; i++)
+            add(std::move(object._data[i]));
+        object.clear();
+        return;
+    }
+
+    _data = object._data;
+    _size = object._size;
+    _capacity = object._capacity;
+
+    object._data = object.allocate(0);
+    object._size = 0;
+    object._capacity = storage_capacity(0);
 }
 
 /*
 * Default constructor.
 */
-template <typename T>
-ABS<T>::ABS()
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS()
 {
     _size = 0;
-    _capacity = 1;
-    _data = new T[_capacity];
+    _capacity = storage_capacity(1);
+    _data = allocate(_capacity);
 }
 
 /*
@@ -155,56 +387,221 @@ ABS<T>::ABS()
 * Parameter:
 * - capacity: Value to which _capacity will be set for new stack.
 */
-template <typename T>
-ABS<T>::ABS(unsigned int capacity)
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS(unsigned int capacity)
 {
     _size = 0;
-    _capacity = capacity;
-    _data = new T[_capacity];
+    _capacity = storage_capacity(capacity);
+    _data = allocate(_capacity);
+}
+
+/*
+* Constructor with assignment to _capacity and _policy.
+*
+* Parameters:
+* - capacity: Value to which _capacity will be set for new stack.
+* - policy: Growth and shrink policy for new stack.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS(unsigned int capacity, const ResizePolicy& policy)
+{
+    _size = 0;
+    _capacity = storage_capacity(capacity);
+    _policy = policy;
+    _data = allocate(_capacity);
+}
+
+/*
+* Constructor with assignment to _allocator. Starts with a capacity of 1 like
+* the default constructor.
+*
+* Parameter:
+* - allocator: Allocator that provides memory for new stack.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS(const Allocator& allocator)
+    : ABS(1, ResizePolicy(), allocator)
+{
+}
+
+/*
+* Constructor with assignment to _capacity, _policy and _allocator.
+*
+* Parameters:
+* - capacity: Value to which _capacity will be set for new stack.
+* - policy: Growth and shrink policy for new stack.
+* - allocator: Allocator that provides memory for new stack.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS(unsigned int capacity, const ResizePolicy& policy, const Allocator& allocator)
+    : _allocator(allocator)
+{
+    _size = 0;
+    _capacity = storage_capacity(capacity);
+    _policy = policy;
+    _data = allocate(_capacity);
 }
 
 /*
 * Copy constructor.
+* The new stack gets the allocator chosen by
+* allocator_traits::select_on_container_copy_construction().
 */
-template <typename T>
-ABS<T>::ABS(const ABS& rhs)
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS(const ABS& rhs)
+    : _allocator(AllocTraits::select_on_container_copy_construction(rhs._allocator))
 {
     copy_from_object(rhs);
 }
 
+/*
+* Move constructor.
+* The allocator is copied, so memory taken from rhs is freed by an equal one.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::ABS(ABS&& rhs) noexcept(N == 0 || std::is_nothrow_move_constructible<T>::value)
+    : _allocator(rhs._allocator)
+{
+    move_from_object(rhs);
+}
+
 /*
 * Copy assignment operator.
 */
-template <typename T>
-ABS<T>& ABS<T>::operator=(const ABS<T>& rhs)
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>& ABS<T, Allocator, N>::operator=(const ABS<T, Allocator, N>& rhs)
 {
-    delete[] _data;
+    if (this == &rhs)
+        return *this;
+
+    release();
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value)
+        _allocator = rhs._allocator;
     copy_from_object(rhs);
 
     return *this;
 }
 
+/*
+* Move assignment operator.
+* rhs's memory is taken over only if the allocator propagates or the two
+* allocators are equal. Otherwise the objects are moved one by one into
+* memory from this stack's own allocator.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>& ABS<T, Allocator, N>::operator=(ABS<T, Allocator, N>&& rhs)
+    noexcept((AllocTraits::propagate_on_container_move_assignment::value
+        || AllocTraits::is_always_equal::value)
+        && (N == 0 || std::is_nothrow_move_constructible<T>::value))
+{
+    if (this == &rhs)
+        return *this;
+
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value)
+    {
+        release();
+        _allocator = rhs._allocator;
+        move_from_object(rhs);
+    }
+    else if (_allocator == rhs._allocator)
+    {
+        release();
+        move_from_object(rhs);
+    }
+    else
+    {
+        // Fill new storage before freeing the old one, so a failed allocation
+        // or transfer leaves this stack as it was. The inline buffer may still
+        // hold this stack's objects, so it is not used as the new storage.
+        unsigned int capacity = storage_capacity(rhs._size);
+        T* moved_data = _data == this->inline_data() ? AllocTraits::allocate(_allocator, capacity) : allocate(capacity);
+        unsigned int i = 0;
+
+        try
+        {
+            for (; i < rhs._size; i++)
+                AllocTraits::construct(_allocator, moved_data + i, std::move_if_noexcept(rhs._data[i]));
+        }
+        catch (...)
+        {
+            while (i > 0)
+                AllocTraits::destroy(_allocator, &moved_data[--i]);
+            deallocate(moved_data, capacity);
+            throw;
+        }
+
+        release();
+        _data = moved_data;
+        _size = rhs._size;
+        _capacity = capacity;
+        _policy = rhs._policy;
+        _reserved = 0;
+        rhs.clear();
+    }
+
+    return *this;
+}
+
 /*
 * Destructor.
 */
-template <typename T>
-ABS<T>::~ABS()
+template <typename T, typename Allocator, unsigned int N>
+ABS<T, Allocator, N>::~ABS()
 {
-    delete[] _data;
+    release();
 }
 
 /*
-* Add a new object to the stack.
+* Copy a new object onto the stack.
 * If necessary, resize the stack to make room for new object.
-
-Parameter:
+*
+* Parameter:
 * - data: Object to be added to the end of stack.
 */
-template <typename T>
-void ABS<T>::push(T data)
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::push(const T& data)
+{
+    emplace(data);
+}
+
+/*
+* Move a new object onto the stack.
+* If necessary, resize the stack to make room for new object.
+*
+* Parameter:
+* - data: Object to be moved to the end of stack.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::push(T&& data)
+{
+    emplace(std::move(data));
+}
+
+/*
+* Construct a new object on the stack from the given arguments.
+* When there is room the object is constructed directly in _data. Otherwise
+* it is built before the resize, so args may refer to objects that are
+* already in the stack.
+*
+* Parameter:
+* - args: Arguments forwarded to a constructor of T.
+*/
+template <typename T, typename Allocator, unsigned int N>
+template <typename... Args>
+void ABS<T, Allocator, N>::emplace(Args&&... args)
 {
-    increase_capacity();
-    add(data);
+    if (_size == _capacity)
+    {
+        T object(std::forward<Args>(args)...);
+        increase_capacity();
+        add(std::move(object));
+        this->record_push(1, _size);
+        return;
+    }
+
+    AllocTraits::construct(_allocator, _data + _size, std::forward<Args>(args)...);
+    _size++;
+    this->record_push(1, _size);
 }
 
 /*
@@ -214,22 +611,144 @@ void ABS<T>::push(T data)
 * Returns:
 * Removed object.
 */
-template <typename T>
-T ABS<T>::pop()
+template <typename T, typename Allocator, unsigned int N>
+T ABS<T, Allocator, N>::pop()
 {
     if (_size == 0)
         throw std::runtime_error("Stack is empty.");
 
     _size--;
+    T data = std::move(_data[_size]);
+    AllocTraits::destroy(_allocator, &_data[_size]);
+    this->record_pop(1);
     shrink_capacity();
-    return _data[_size];
+    return data;
+}
+
+/*
+* Copy an array of objects onto the stack, in order, so data[count - 1] ends
+* up on top. Capacity is increased at most once for the whole array, and
+* trivially copyable objects are copied with a single memcpy.
+*
+* Parameters:
+* - data: First object to be added. Must not point into this stack.
+* - count: Number of objects to add.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::push_range(const T* data, unsigned int count)
+{
+    increase_capacity(count);
+
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        if (count > 0)
+            std::memcpy(_data + _size, data, count * sizeof(T));
+        _size += count;
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; i++)
+            add(data[i]);
+    }
+
+    this->record_push(count, _size);
+}
+
+/*
+* Remove the top objects from the stack in one step.
+* The objects are written in the order they were pushed, so pop_range()
+* undoes push_range(): data[0] is the deepest removed object and
+* data[n - 1] was the top. The stack is shrunk at most once.
+*
+* Parameters:
+* - data: Array of at least count objects that receives the removed objects.
+* - count: Maximum number of objects to remove.
+*
+* Returns:
+* Number of objects removed, min(count, getSize()).
+*/
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABS<T, Allocator, N>::pop_range(T* data, unsigned int count)
+{
+    if (count > _size)
+        count = _size;
+
+    _size -= count;
+
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        if (count > 0)
+            std::memcpy(data, _data + _size, count * sizeof(T));
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            data[i] = std::move(_data[_size + i]);
+            AllocTraits::destroy(_allocator, &_data[_size + i]);
+        }
+    }
+
+    this->record_pop(count);
+    shrink_capacity();
+    return count;
+}
+
+/*
+* Make room for at least capacity objects now, so later insertions up to that
+* size never reallocate. The reserved capacity also becomes a floor for
+* automatic shrinking, kept apart from the ResizePolicy, so draining the
+* stack does not give the memory back either.
+*
+* Parameter:
+* - capacity: Number of objects the stack must hold without reallocating.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::reserve(unsigned int capacity)
+{
+    if (capacity > _capacity)
+        resize(capacity);
+
+    if (capacity > _reserved)
+        _reserved = capacity;
+}
+
+/*
+* Drop the floor set by reserve(), so automatic shrinking applies again, and
+* reallocate _data to hold just the current objects, but never less than
+* _policy.min_capacity.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::shrink_to_fit()
+{
+    _reserved = 0;
+
+    unsigned int capacity = _size > min_capacity() ? _size : min_capacity();
+    if (capacity < _capacity)
+        resize(capacity);
+}
+
+/*
+* Destroy every object in the stack. _capacity is kept so the stack can be
+* refilled without reallocating.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::clear()
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        for (unsigned int i = 0; i < _size; i++)
+            AllocTraits::destroy(_allocator, &_data[i]);
+    }
+
+    _size = 0;
 }
 
 /*
 * View the first object in the stack.
 */
-template <typename T>
-T ABS<T>::peek() const
+template <typename T, typename Allocator, unsigned int N>
+T ABS<T, Allocator, N>::peek() const
 {
     if (_size == 0)
     throw std::runtime_error("Stack is empty.");
@@ -241,8 +760,8 @@ T ABS<T>::peek() const
 * Returns:
 * Current size of the stack.
 */
-template <typename T>
-unsigned int ABS<T>::getSize() const
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABS<T, Allocator, N>::getSize() const
 {
     return _size;
 }
@@ -251,8 +770,8 @@ unsigned int ABS<T>::getSize() const
 * Returns:
 * Current capacity of the stack.
 */
-template <typename T>
-unsigned int ABS<T>::getMaxCapacity() const
+template <typename T, typename Allocator, unsigned int N>
+unsigned int ABS<T, Allocator, N>::getMaxCapacity() const
 {
     return _capacity;
 }
@@ -261,20 +780,73 @@ unsigned int ABS<T>::getMaxCapacity() const
 * Returns:
 * Stack's dynamic array.
 */
-template <typename T>
-T* ABS<T>::getData() const
+template <typename T, typename Allocator, unsigned int N>
+T* ABS<T, Allocator, N>::getData() const
     {
         return _data;
     }
 
+/*
+* Returns:
+* Growth and shrink policy of the stack.
+*/
+template <typename T, typename Allocator, unsigned int N>
+const ResizePolicy& ABS<T, Allocator, N>::getResizePolicy() const
+{
+    return _policy;
+}
+
+/*
+* Returns:
+* Copy of the allocator that provides memory for the stack.
+*/
+template <typename T, typename Allocator, unsigned int N>
+Allocator ABS<T, Allocator, N>::getAllocator() const
+{
+    return _allocator;
+}
+
+/*
+* Returns:
+* Operation and resize counters for this stack. All zero unless compiled
+* with CONTAINER_STATS.
+*/
+template <typename T, typename Allocator, unsigned int N>
+ContainerStats ABS<T, Allocator, N>::getStats() const
+{
+    return this->stats();
+}
+
+/*
+* Replace the growth and shrink policy of the stack.
+* The new policy takes effect on the next push or pop.
+*
+* Parameter:
+* - policy: New growth and shrink policy.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::setResizePolicy(const ResizePolicy& policy)
+{
+    _policy = policy;
+}
+
+/*
+* Zero every counter returned by getStats(), e.g. after a warm-up phase.
+*/
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::resetStats()
+{
+    this->reset_stats();
+}
+
 /*
 * Debug tool for printing all member variables of a stack.
 */
-template <typename T> 
-void ABS<T>::print()
+template <typename T, typename Allocator, unsigned int N>
+void ABS<T, Allocator, N>::print()
 {
     cout << "_data contents: ";
-    for (unsigned int i = 0; i < _capacity; i++)
+    for (unsigned int i = 0; i < _size; i++)
     {
         cout << _data[i] << " ";
     }
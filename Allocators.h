@@ -0,0 +1,476 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+// Memory resources for carving many short-lived ABS/ABQ containers out of a
+// few large blocks. Both are std::pmr::memory_resource objects, so they work
+// with std::pmr::polymorphic_allocator<T> as well as with the non-virtual
+// ArenaAllocator<T> and PoolAllocator<T> below.
+//
+//     MonotonicArena arena;
+//     ABS<int, ArenaAllocator<int>> stack(&arena);
+//     ABQ<int, std::pmr::polymorphic_allocator<int>> queue(&arena);
+//     ...
+//     arena.release();     // every container carved from arena is gone at once
+//
+// Containers must be destroyed (or simply abandoned, for trivially
+// destructible T) before their resource is released.
+
+// MonotonicArena hands out memory by bumping a pointer through large chunks
+// and frees nothing until release() or destruction.
+class MonotonicArena final : public std::pmr::memory_resource
+{
+private:
+    struct Chunk
+    {
+        Chunk* next;                            // Previously filled chunk
+        std::size_t size;                       // Bytes in this chunk, header included
+    };
+
+    // Member variables
+    std::pmr::memory_resource* _upstream;       // Source of chunks
+    Chunk* _chunks;                             // Most recent chunk, head of the list
+    unsigned char* _current;                    // Next free byte in the most recent chunk
+    unsigned char* _end;                        // One past the last byte of the most recent chunk
+    std::size_t _next_chunk_size;               // Size of the next chunk to request
+    std::size_t _bytes_used;                    // Bytes handed out since the last release()
+
+    // Class variable
+    static constexpr std::size_t SCALE_FACTOR = 2; // Chunk size growth between refills
+
+    // Private behaviors
+    void add_chunk(std::size_t bytes, std::size_t alignment); // Request a chunk large enough for one allocation
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+    // Constructors
+    MonotonicArena(std::size_t chunk_size = 64 * 1024,
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    MonotonicArena(const MonotonicArena& rhs) = delete;
+    MonotonicArena& operator=(const MonotonicArena& rhs) = delete;
+
+    ~MonotonicArena();                          // Destructor
+
+    // Behaviors
+    void release();                             // Return every chunk to upstream
+
+    // Accessors
+    std::size_t getBytesUsed() const;           // _bytes_used getter
+};
+
+// FixedPool serves every request of up to block_size bytes from a free list of
+// equally sized blocks, so freed blocks are reused immediately. Larger or
+// over-aligned requests are passed straight to upstream.
+class FixedPool final : public std::pmr::memory_resource
+{
+private:
+    struct Block
+    {
+        Block* next;                            // Next free block
+    };
+
+    struct Chunk
+    {
+        Chunk* next;                            // Previously allocated chunk
+    };
+
+    // Member variables
+    std::pmr::memory_resource* _upstream;       // Source of chunks and oversized blocks
+    std::size_t _block_size;                    // Bytes per block, a multiple of alignof(max_align_t)
+    std::size_t _blocks_per_chunk;              // Blocks carved from each chunk
+    Block* _free;                               // Head of the free list
+    Chunk* _chunks;                             // Head of the chunk list
+
+    // Private behaviors
+    bool fits(std::size_t bytes, std::size_t alignment) const; // True if a block can serve the request
+    std::size_t chunk_bytes() const;            // Size of one chunk, header included
+    void add_chunk();                           // Carve a new chunk into free blocks
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+    // Constructors
+    FixedPool(std::size_t block_size, std::size_t blocks_per_chunk = 256,
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    FixedPool(const FixedPool& rhs) = delete;
+    FixedPool& operator=(const FixedPool& rhs) = delete;
+
+    ~FixedPool();                               // Destructor
+
+    // Behaviors
+    void release();                             // Return every chunk to upstream
+
+    // Accessors
+    std::size_t getBlockSize() const;           // _block_size getter
+};
+
+// ResourceAllocator is a std::allocator-compatible handle to a Resource. Since
+// both resources are final, calls through it are not virtual.
+template <typename T, typename Resource>
+class ResourceAllocator
+{
+private:
+    Resource* _resource;                        // Resource that owns the memory
+
+    template <typename U, typename R>
+    friend class ResourceAllocator;
+
+public:
+    using value_type = T;
+
+    // Constructors
+    ResourceAllocator(Resource* resource) noexcept; // Constructor with resource
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& rhs) noexcept; // Rebinding constructor
+
+    // Behaviors
+    T* allocate(std::size_t count);             // Storage for count objects
+    void deallocate(T* ptr, std::size_t count); // Return storage from allocate()
+
+    // Accessors
+    Resource* getResource() const;              // _resource getter
+
+    template <typename U>
+    bool operator==(const ResourceAllocator<U, Resource>& rhs) const;
+    template <typename U>
+    bool operator!=(const ResourceAllocator<U, Resource>& rhs) const;
+};
+
+template <typename T>
+using ArenaAllocator = ResourceAllocator<T, MonotonicArena>;
+
+template <typename T>
+using PoolAllocator = ResourceAllocator<T, FixedPool>;
+
+/*
+* Constructor.
+*
+* Parameters:
+* - chunk_size: Size of the first chunk. Later chunks grow by SCALE_FACTOR.
+* - upstream: Resource that provides chunks.
+*/
+inline MonotonicArena::MonotonicArena(std::size_t chunk_size, std::pmr::memory_resource* upstream)
+{
+    _upstream = upstream;
+    _chunks = nullptr;
+    _current = nullptr;
+    _end = nullptr;
+    _next_chunk_size = chunk_size > sizeof(Chunk) ? chunk_size : 2 * sizeof(Chunk);
+    _bytes_used = 0;
+}
+
+/*
+* Destructor.
+*/
+inline MonotonicArena::~MonotonicArena()
+{
+    release();
+}
+
+/*
+* Helper function.
+* Requests a chunk big enough for bytes at alignment, at least as large as
+* _next_chunk_size, and makes it the current chunk.
+*/
+inline void MonotonicArena::add_chunk(std::size_t bytes, std::size_t alignment)
+{
+    std::size_t size = _next_chunk_size;
+    while (size < sizeof(Chunk) + bytes + alignment)
+        size *= SCALE_FACTOR;
+
+    Chunk* chunk = static_cast<Chunk*>(_upstream->allocate(size, alignof(std::max_align_t)));
+    chunk->next = _chunks;
+    chunk->size = size;
+
+    _chunks = chunk;
+    _current = reinterpret_cast<unsigned char*>(chunk) + sizeof(Chunk);
+    _end = reinterpret_cast<unsigned char*>(chunk) + size;
+    _next_chunk_size = size * SCALE_FACTOR;
+}
+
+/*
+* Bumps _current past an aligned block of bytes, adding a chunk if needed.
+*/
+inline void* MonotonicArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(_current);
+    std::uintptr_t aligned = (address + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+
+    if (!_current || aligned + bytes > reinterpret_cast<std::uintptr_t>(_end))
+    {
+        add_chunk(bytes, alignment);
+        address = reinterpret_cast<std::uintptr_t>(_current);
+        aligned = (address + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+    }
+
+    _current = reinterpret_cast<unsigned char*>(aligned + bytes);
+    _bytes_used += bytes;
+    return reinterpret_cast<void*>(aligned);
+}
+
+/*
+* Does nothing: memory comes back all at once in release().
+*/
+inline void MonotonicArena::do_deallocate(void*, std::size_t, std::size_t)
+{
+}
+
+/*
+* Returns:
+* True only for the same arena, since memory cannot be freed elsewhere.
+*/
+inline bool MonotonicArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+/*
+* Return every chunk to upstream. Everything allocated from the arena becomes
+* invalid. The next chunk starts at the size of the largest one released.
+*/
+inline void MonotonicArena::release()
+{
+    std::size_t largest = 0;
+
+    while (_chunks)
+    {
+        Chunk* next = _chunks->next;
+        if (_chunks->size > largest)
+            largest = _chunks->size;
+        _upstream->deallocate(_chunks, _chunks->size, alignof(std::max_align_t));
+        _chunks = next;
+    }
+
+    if (largest)
+        _next_chunk_size = largest;
+    _current = nullptr;
+    _end = nullptr;
+    _bytes_used = 0;
+}
+
+/*
+* Returns:
+* Bytes handed out since the last release(), not counting alignment padding.
+*/
+inline std::size_t MonotonicArena::getBytesUsed() const
+{
+    return _bytes_used;
+}
+
+/*
+* Constructor.
+*
+* Parameters:
+* - block_size: Largest request served from the pool. Rounded up to a
+*   multiple of alignof(std::max_align_t).
+* - blocks_per_chunk: Number of blocks requested from upstream at a time.
+* - upstream: Resource that provides chunks and oversized blocks.
+*/
+inline FixedPool::FixedPool(std::size_t block_size, std::size_t blocks_per_chunk,
+    std::pmr::memory_resource* upstream)
+{
+    const std::size_t alignment = alignof(std::max_align_t);
+
+    if (block_size < sizeof(Block))
+        block_size = sizeof(Block);
+
+    _upstream = upstream;
+    _block_size = (block_size + alignment - 1) / alignment * alignment;
+    _blocks_per_chunk = blocks_per_chunk > 0 ? blocks_per_chunk : 1;
+    _free = nullptr;
+    _chunks = nullptr;
+}
+
+/*
+* Destructor.
+*/
+inline FixedPool::~FixedPool()
+{
+    release();
+}
+
+/*
+* Helper function.
+* Returns true if the request can be served by one block.
+*/
+inline bool FixedPool::fits(std::size_t bytes, std::size_t alignment) const
+{
+    return bytes <= _block_size && alignment <= alignof(std::max_align_t);
+}
+
+/*
+* Helper function.
+* Returns the size of one chunk. The header is padded so blocks stay aligned.
+*/
+inline std::size_t FixedPool::chunk_bytes() const
+{
+    return alignof(std::max_align_t) + _block_size * _blocks_per_chunk;
+}
+
+/*
+* Helper function.
+* Requests a chunk from upstream and threads its blocks onto the free list.
+*/
+inline void FixedPool::add_chunk()
+{
+    unsigned char* memory = static_cast<unsigned char*>(
+        _upstream->allocate(chunk_bytes(), alignof(std::max_align_t)));
+
+    Chunk* chunk = reinterpret_cast<Chunk*>(memory);
+    chunk->next = _chunks;
+    _chunks = chunk;
+
+    unsigned char* blocks = memory + alignof(std::max_align_t);
+    for (std::size_t i = _blocks_per_chunk; i > 0; i--)
+    {
+        Block* block = reinterpret_cast<Block*>(blocks + (i - 1) * _block_size);
+        block->next = _free;
+        _free = block;
+    }
+}
+
+/*
+* Pops a block from the free list, or forwards oversized requests upstream.
+*/
+inline void* FixedPool::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if (!fits(bytes, alignment))
+        return _upstream->allocate(bytes, alignment);
+
+    if (!_free)
+        add_chunk();
+
+    Block* block = _free;
+    _free = block->next;
+    return block;
+}
+
+/*
+* Pushes a block back onto the free list, or forwards oversized blocks upstream.
+*/
+inline void FixedPool::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+{
+    if (!fits(bytes, alignment))
+    {
+        _upstream->deallocate(ptr, bytes, alignment);
+        return;
+    }
+
+    Block* block = static_cast<Block*>(ptr);
+    block->next = _free;
+    _free = block;
+}
+
+/*
+* Returns:
+* True only for the same pool.
+*/
+inline bool FixedPool::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+/*
+* Return every chunk to upstream. Every block from the pool becomes invalid.
+* Oversized blocks that were forwarded upstream are not affected.
+*/
+inline void FixedPool::release()
+{
+    while (_chunks)
+    {
+        Chunk* next = _chunks->next;
+        _upstream->deallocate(_chunks, chunk_bytes(), alignof(std::max_align_t));
+        _chunks = next;
+    }
+
+    _free = nullptr;
+}
+
+/*
+* Returns:
+* Largest request served from the pool, in bytes.
+*/
+inline std::size_t FixedPool::getBlockSize() const
+{
+    return _block_size;
+}
+
+/*
+* Constructor with assignment to _resource.
+*/
+template <typename T, typename Resource>
+ResourceAllocator<T, Resource>::ResourceAllocator(Resource* resource) noexcept
+{
+    _resource = resource;
+}
+
+/*
+* Rebinding constructor: shares rhs's resource.
+*/
+template <typename T, typename Resource>
+template <typename U>
+ResourceAllocator<T, Resource>::ResourceAllocator(const ResourceAllocator<U, Resource>& rhs) noexcept
+{
+    _resource = rhs._resource;
+}
+
+/*
+* Returns:
+* Uninitialized storage for count objects of type T.
+*/
+template <typename T, typename Resource>
+T* ResourceAllocator<T, Resource>::allocate(std::size_t count)
+{
+    return static_cast<T*>(_resource->allocate(count * sizeof(T), alignof(T)));
+}
+
+/*
+* Returns storage from allocate() to the resource.
+*/
+template <typename T, typename Resource>
+void ResourceAllocator<T, Resource>::deallocate(T* ptr, std::size_t count)
+{
+    _resource->deallocate(ptr, count * sizeof(T), alignof(T));
+}
+
+/*
+* Returns:
+* Resource that owns the memory.
+*/
+template <typename T, typename Resource>
+Resource* ResourceAllocator<T, Resource>::getResource() const
+{
+    return _resource;
+}
+
+/*
+* Returns:
+* True if both allocators share a resource, so either can free the other's memory.
+*/
+template <typename T, typename Resource>
+template <typename U>
+bool ResourceAllocator<T, Resource>::operator==(const ResourceAllocator<U, Resource>& rhs) const
+{
+    return _resource == rhs._resource;
+}
+
+/*
+* Returns:
+* True if the allocators use different resources.
+*/
+template <typename T, typename Resource>
+template <typename U>
+bool ResourceAllocator<T, Resource>::operator!=(const ResourceAllocator<U, Resource>& rhs) const
+{
+    return _resource != rhs._resource;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+// Size of a cache line. Indices written by different threads are kept this far
+// apart so they do not invalidate each other's lines.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+
+// ContainerStats is a snapshot of what an ABS or ABQ has done since it was
+// constructed (or since resetStats()). The counters are only kept when the
+// program is compiled with -DCONTAINER_STATS; otherwise getStats() returns
+// all zeros and the containers carry no extra state or work.
+//
+// CONTAINER_STATS changes the layout of ABS and ABQ, so it must be defined
+// the same way for every translation unit of a program.
+struct ContainerStats
+{
+    unsigned long long pushes = 0;              // Objects added by push/enqueue/emplace and their bulk forms
+    unsigned long long pops = 0;                // Objects removed by pop/dequeue and their bulk forms
+    unsigned long long grows = 0;               // Reallocations to a larger capacity
+    unsigned long long shrinks = 0;             // Reallocations to a smaller capacity
+    unsigned long long bytes_copied = 0;        // Bytes transferred between arrays by reallocations
+    unsigned int high_water = 0;                // Largest size reached
+
+    std::string toJSON() const;                 // One-line JSON object with every counter
+};
+
+/*
+* Returns:
+* The counters as {"pushes":..,"pops":..,"grows":..,"shrinks":..,
+* "bytes_copied":..,"high_water":..}.
+*/
+inline std::string ContainerStats::toJSON() const
+{
+    return "{\"pushes\":" + std::to_string(pushes)
+        + ",\"pops\":" + std::to_string(pops)
+        + ",\"grows\":" + std::to_string(grows)
+        + ",\"shrinks\":" + std::to_string(shrinks)
+        + ",\"bytes_copied\":" + std::to_string(bytes_copied)
+        + ",\"high_water\":" + std::to_string(high_water) + "}";
+}
+
+// StatsRecorder is a private base of ABS and ABQ, like InlineBuffer. With
+// CONTAINER_STATS it holds a ContainerStats; without it the class is empty
+// and every record_*() call compiles away.
+#ifdef CONTAINER_STATS
+
+class StatsRecorder
+{
+private:
+    ContainerStats _stats;                      // Counters for the owning container
+
+protected:
+    void record_push(unsigned int count, unsigned int size) // count objects added, size is the new size
+    {
+        _stats.pushes += count;
+        if (size > _stats.high_water)
+            _stats.high_water = size;
+    }
+
+    void record_pop(unsigned int count)         // count objects removed
+    {
+        _stats.pops += count;
+    }
+
+    void record_resize(bool grew, unsigned long long bytes) // One reallocation that transferred bytes
+    {
+        if (grew)
+            _stats.grows++;
+        else
+            _stats.shrinks++;
+        _stats.bytes_copied += bytes;
+    }
+
+    ContainerStats stats() const { return _stats; }
+    void reset_stats() { _stats = ContainerStats(); }
+};
+
+#else
+
+class StatsRecorder
+{
+protected:
+    void record_push(unsigned int, unsigned int) {}
+    void record_pop(unsigned int) {}
+    void record_resize(bool, unsigned long long) {}
+
+    ContainerStats stats() const { return ContainerStats(); }
+    void reset_stats() {}
+};
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+// InlineBuffer holds raw, uninitialized space for N objects of type T inside
+// the object that inherits from it. ABS and ABQ use it for small-buffer
+// optimization: the first N objects live in the container itself and only
+// larger sizes go to the allocator. The N == 0 specialization is empty, so
+// containers without inline storage pay nothing for it.
+template <typename T, unsigned int N>
+class InlineBuffer
+{
+private:
+    alignas(T) unsigned char _inline_storage[N * sizeof(T)]; // Space for N objects
+
+protected:
+    T* inline_data() { return reinterpret_cast<T*>(_inline_storage); } // First inline slot
+};
+
+template <typename T>
+class InlineBuffer<T, 0>
+{
+protected:
+    T* inline_data() { return nullptr; }        // No inline slots
+};
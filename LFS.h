@@ -0,0 +1,340 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "CacheLine.h"
+
+// LFS class is a lock-free (Treiber) stack that any number of threads may push
+// to and pop from at once.
+//
+// Nodes are never returned to the system while the stack is alive. A popped
+// node goes onto an internal free list (itself a Treiber stack) and is reused
+// by a later push, so a thread that is still reading a node's next index can
+// never touch freed memory. Nodes are named by 32-bit indices and each list
+// head packs (tag << 32 | index) into one 64-bit word. Every successful CAS
+// bumps the tag, so a head that was popped and pushed back in between (ABA)
+// no longer compares equal.
+//
+// Node storage grows like ABS: chunk k holds BASE_NODES * 2^k nodes, so the
+// number of chunks stays small and existing nodes never move.
+template <typename T>
+class LFS                                       // Lock-free stack
+{
+private:
+    struct Node
+    {
+        std::atomic<std::uint32_t> next;        // Index of the node below this one
+        alignas(T) unsigned char storage[sizeof(T)]; // Raw space for one object
+    };
+
+    static constexpr std::uint32_t NIL = 0xFFFFFFFFu; // Index meaning "no node"
+    static constexpr unsigned int BASE_BITS = 5; // First chunk holds 2^BASE_BITS nodes
+    static constexpr std::uint32_t BASE_NODES = 1u << BASE_BITS;
+    static constexpr unsigned int MAX_CHUNKS = 32 - BASE_BITS; // Chunks needed to cover 32-bit indices
+
+    // Member variables
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> _top; // Tagged head of the stack
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> _free; // Tagged head of the free list
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned int> _size; // Current size of the stack
+    std::atomic<std::uint32_t> _allocated;      // Number of node indices handed out so far
+    std::atomic<Node*> _chunks[MAX_CHUNKS];     // Node storage, allocated on demand
+    std::mutex _grow_lock;                      // Serializes chunk allocation only
+
+    // Private behaviors
+    static unsigned int chunk_of(std::uint32_t index); // Chunk that holds a node index
+    static std::uint32_t chunk_start(unsigned int chunk); // First node index in a chunk
+    Node& node(std::uint32_t index) const;      // Look up a node by index
+    std::uint32_t new_node();                   // Take a node from the free list or grow
+    void push_index(std::atomic<std::uint64_t>& head, std::uint32_t index); // Push a node onto a list
+    std::uint32_t pop_index(std::atomic<std::uint64_t>& head); // Pop a node from a list, NIL if empty
+
+public:
+    // Constructors
+    LFS();                                      // Default constructor
+    LFS(const LFS& rhs) = delete;               // Not copyable: nodes are shared with running threads
+    LFS& operator=(const LFS& rhs) = delete;
+
+    ~LFS();                                     // Destructor
+
+    // Behaviors
+    void push(const T& data);                   // Copy onto stack
+    void push(T&& data);                        // Move onto stack
+    template <typename... Args>
+    void emplace(Args&&... args);               // Construct a new object on the stack from args
+    T pop();                                    // Remove and return last item in stack, throws if empty
+    bool try_pop(T& data);                      // Move last item into data, false if empty
+
+    // Accessors
+    unsigned int getSize() const;               // Approximate size when called concurrently
+};
+
+/*
+* Helper function.
+* Returns the chunk that holds the given node index.
+* Chunk k covers indices [BASE_NODES * (2^k - 1), BASE_NODES * (2^(k+1) - 1)).
+*/
+template <typename T>
+unsigned int LFS<T>::chunk_of(std::uint32_t index)
+{
+    std::uint32_t j = (index >> BASE_BITS) + 1;
+    unsigned int chunk = 0;
+
+    while (j >>= 1)
+        chunk++;
+
+    return chunk;
+}
+
+/*
+* Helper function.
+* Returns the first node index stored in the given chunk.
+*/
+template <typename T>
+std::uint32_t LFS<T>::chunk_start(unsigned int chunk)
+{
+    return BASE_NODES * ((1u << chunk) - 1);
+}
+
+/*
+* Helper function.
+* Returns the node with the given index. The node's chunk must exist.
+*/
+template <typename T>
+typename LFS<T>::Node& LFS<T>::node(std::uint32_t index) const
+{
+    unsigned int chunk = chunk_of(index);
+    return _chunks[chunk].load(std::memory_order_acquire)[index - chunk_start(chunk)];
+}
+
+/*
+* Helper function.
+* Reuses a node from the free list, or hands out a fresh index and allocates
+* its chunk if this is the first index in that chunk.
+*
+* Returns:
+* Index of a node owned by the caller.
+*/
+template <typename T>
+std::uint32_t LFS<T>::new_node()
+{
+    std::uint32_t index = pop_index(_free);
+    if (index != NIL)
+        return index;
+
+    // Check before taking the index, so pushes onto a full stack leave
+    // _allocated alone instead of counting it up until it wraps
+    index = _allocated.load(std::memory_order_relaxed);
+    do
+    {
+        if (index >= chunk_start(MAX_CHUNKS))
+            throw std::runtime_error("Stack is full.");
+    } while (!_allocated.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    unsigned int chunk = chunk_of(index);
+    if (!_chunks[chunk].load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> guard(_grow_lock);
+        if (!_chunks[chunk].load(std::memory_order_relaxed))
+            _chunks[chunk].store(new Node[BASE_NODES << chunk], std::memory_order_release);
+    }
+
+    return index;
+}
+
+/*
+* Helper function.
+* Pushes a node owned by the caller onto a tagged list head.
+*/
+template <typename T>
+void LFS<T>::push_index(std::atomic<std::uint64_t>& head, std::uint32_t index)
+{
+    Node& pushed = node(index);
+    std::uint64_t old_head = head.load(std::memory_order_relaxed);
+    std::uint64_t new_head;
+
+    do
+    {
+        pushed.next.store((std::uint32_t)old_head, std::memory_order_relaxed);
+        new_head = (((old_head >> 32) + 1) << 32) | index;
+    } while (!head.compare_exchange_weak(old_head, new_head,
+        std::memory_order_release, std::memory_order_relaxed));
+}
+
+/*
+* Helper function.
+* Pops a node from a tagged list head. The caller then owns the node.
+*
+* Returns:
+* Index of the popped node, or NIL if the list is empty.
+*/
+template <typename T>
+std::uint32_t LFS<T>::pop_index(std::atomic<std::uint64_t>& head)
+{
+    std::uint64_t old_head = head.load(std::memory_order_acquire);
+
+    while ((std::uint32_t)old_head != NIL)
+    {
+        // The node may be popped and reused by another thread while we read
+        // next; the tag makes our CAS fail in that case
+        std::uint32_t next = node((std::uint32_t)old_head).next.load(std::memory_order_relaxed);
+        std::uint64_t new_head = (((old_head >> 32) + 1) << 32) | next;
+
+        if (head.compare_exchange_weak(old_head, new_head,
+            std::memory_order_acquire, std::memory_order_acquire))
+            return (std::uint32_t)old_head;
+    }
+
+    return NIL;
+}
+
+/*
+* Default constructor.
+*/
+template <typename T>
+LFS<T>::LFS()
+{
+    _top.store(NIL, std::memory_order_relaxed);
+    _free.store(NIL, std::memory_order_relaxed);
+    _size.store(0, std::memory_order_relaxed);
+    _allocated.store(0, std::memory_order_relaxed);
+
+    for (unsigned int i = 0; i < MAX_CHUNKS; i++)
+        _chunks[i].store(nullptr, std::memory_order_relaxed);
+}
+
+/*
+* Destructor.
+* Must not run while any thread is still using the stack.
+*/
+template <typename T>
+LFS<T>::~LFS()
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        std::uint32_t index = (std::uint32_t)_top.load(std::memory_order_relaxed);
+        while (index != NIL)
+        {
+            Node& popped = node(index);
+            std::launder(reinterpret_cast<T*>(popped.storage))->~T();
+            index = popped.next.load(std::memory_order_relaxed);
+        }
+    }
+
+    for (unsigned int i = 0; i < MAX_CHUNKS; i++)
+        delete[] _chunks[i].load(std::memory_order_relaxed);
+}
+
+/*
+* Copy a new object onto the stack.
+*
+* Parameter:
+* - data: Object to be added to the top of stack.
+*/
+template <typename T>
+void LFS<T>::push(const T& data)
+{
+    emplace(data);
+}
+
+/*
+* Move a new object onto the stack.
+*
+* Parameter:
+* - data: Object to be moved to the top of stack.
+*/
+template <typename T>
+void LFS<T>::push(T&& data)
+{
+    emplace(std::move(data));
+}
+
+/*
+* Construct a new object on the stack from the given arguments.
+*
+* Parameter:
+* - args: Arguments forwarded to a constructor of T.
+*/
+template <typename T>
+template <typename... Args>
+void LFS<T>::emplace(Args&&... args)
+{
+    std::uint32_t index = new_node();
+
+    try
+    {
+        new (node(index).storage) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        push_index(_free, index);
+        throw;
+    }
+
+    _size.fetch_add(1, std::memory_order_relaxed);
+    push_index(_top, index);
+}
+
+/*
+* Remove the last object from the stack.
+*
+* Returns:
+* Removed object.
+*/
+template <typename T>
+T LFS<T>::pop()
+{
+    std::uint32_t index = pop_index(_top);
+
+    if (index == NIL)
+        throw std::runtime_error("Stack is empty.");
+
+    T* object = std::launder(reinterpret_cast<T*>(node(index).storage));
+    T data = std::move(*object);
+    object->~T();
+
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    push_index(_free, index);
+    return data;
+}
+
+/*
+* Remove the last object from the stack.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the stack was empty.
+*/
+template <typename T>
+bool LFS<T>::try_pop(T& data)
+{
+    std::uint32_t index = pop_index(_top);
+
+    if (index == NIL)
+        return false;
+
+    T* object = std::launder(reinterpret_cast<T*>(node(index).storage));
+    data = std::move(*object);
+    object->~T();
+
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    push_index(_free, index);
+    return true;
+}
+
+/*
+* Returns:
+* Number of objects in the stack. Exact only when no thread is mid-operation.
+*/
+template <typename T>
+unsigned int LFS<T>::getSize() const
+{
+    return _size.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "CacheLine.h"
+
+// MPMCQ class is a bounded lock-free queue that any number of producer and
+// consumer threads may use at once. It follows Dmitry Vyukov's bounded MPMC
+// design: every slot carries a sequence number saying whose turn it is.
+//
+// For the slot at position pos (pos counts up forever, the slot is pos & _mask):
+// - sequence == pos            the slot is empty and may be filled by enqueue #pos
+// - sequence == pos + 1        the slot is full and may be taken by dequeue #pos
+// - sequence == pos + capacity the slot is empty again for the next lap
+// Producers race on _tail and consumers on _head with a single CAS each; the
+// sequence store publishes the slot to the other side.
+//
+// Once a slot is claimed its sequence must advance, or every later thread
+// waits on it forever, so nothing between the claim and the sequence store may
+// throw. T must therefore be nothrow move constructible and destructible;
+// objects whose construction may throw are built before a slot is claimed.
+template <typename T>
+class MPMCQ                                     // Multi-producer/multi-consumer queue
+{
+    static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_destructible<T>::value,
+        "MPMCQ requires a T that is nothrow move constructible and destructible");
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;      // Turn counter for this slot
+        alignas(T) unsigned char storage[sizeof(T)]; // Raw space for one object
+    };
+
+    // Shared, read-only after construction
+    alignas(CACHE_LINE_SIZE) Slot* _slots;      // Ring of slots
+    std::size_t _capacity;                      // Number of slots, always a power of two
+    std::size_t _mask;                          // _capacity - 1, for wrapping a position into _slots
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head; // Next position to dequeue
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail; // Next position to enqueue
+
+    // Private behaviors
+    static std::size_t round_up(unsigned int capacity); // Smallest power of two >= capacity
+    static T* object(Slot* slot);               // The object stored in a slot
+    Slot* claim_enqueue(std::size_t& pos);      // Reserve an empty slot, nullptr if full
+    Slot* claim_dequeue(std::size_t& pos);      // Reserve a full slot, nullptr if empty
+
+public:
+    // Constructors
+    MPMCQ(unsigned int capacity);               // Constructor with specified capacity (rounded up to a power of two)
+    MPMCQ(const MPMCQ& rhs) = delete;           // Not copyable: slots are owned by running threads
+    MPMCQ& operator=(const MPMCQ& rhs) = delete;
+
+    ~MPMCQ();                                   // Destructor
+
+    // Behaviors
+    void enqueue(const T& data);                // Copy onto queue, throws if full
+    void enqueue(T&& data);                     // Move onto queue, throws if full
+    T dequeue();                                // Remove and return first item, throws if empty
+    bool try_enqueue(const T& data);            // Copy onto queue, false if full
+    bool try_enqueue(T&& data);                 // Move onto queue, false if full
+    template <typename... Args>
+    bool try_emplace(Args&&... args);           // Construct onto queue from args, false if full
+    bool try_dequeue(T& data);                  // Move first item into data, false if empty
+
+    // Accessors
+    unsigned int getSize() const;               // Approximate size when called concurrently
+    unsigned int getMaxCapacity() const;        // _capacity getter
+};
+
+/*
+* Helper function.
+* Rounds capacity up to the next power of two so positions wrap with a mask.
+*
+* Parameter:
+* - capacity: Requested capacity.
+*/
+template <typename T>
+std::size_t MPMCQ<T>::round_up(unsigned int capacity)
+{
+    std::size_t rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    return rounded;
+}
+
+/*
+* Helper function.
+* Returns the object living in the raw storage of a slot.
+*/
+template <typename T>
+T* MPMCQ<T>::object(Slot* slot)
+{
+    return std::launder(reinterpret_cast<T*>(slot->storage));
+}
+
+/*
+* Helper function.
+* Advances _tail past an empty slot. The caller must construct an object in
+* the slot and then store (pos + 1) into its sequence.
+*
+* Parameter:
+* - pos: Receives the claimed position.
+*
+* Returns:
+* Claimed slot, or nullptr if the queue is full.
+*/
+template <typename T>
+typename MPMCQ<T>::Slot* MPMCQ<T>::claim_enqueue(std::size_t& pos)
+{
+    pos = _tail.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        Slot* slot = &_slots[pos & _mask];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+
+        if (diff == 0)
+        {
+            // Our turn: try to take the position (pos is reloaded on failure)
+            if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return slot;
+        }
+        else if (diff < 0)
+            return nullptr;         // Slot still holds last lap's object: full
+        else
+            pos = _tail.load(std::memory_order_relaxed); // Another producer got here first
+    }
+}
+
+/*
+* Helper function.
+* Advances _head past a full slot. The caller must move the object out,
+* destroy it, and then store (pos + _capacity) into the slot's sequence.
+*
+* Parameter:
+* - pos: Receives the claimed position.
+*
+* Returns:
+* Claimed slot, or nullptr if the queue is empty.
+*/
+template <typename T>
+typename MPMCQ<T>::Slot* MPMCQ<T>::claim_dequeue(std::size_t& pos)
+{
+    pos = _head.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        Slot* slot = &_slots[pos & _mask];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(pos + 1);
+
+        if (diff == 0)
+        {
+            if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return slot;
+        }
+        else if (diff < 0)
+            return nullptr;         // Slot not filled yet: empty
+        else
+            pos = _head.load(std::memory_order_relaxed); // Another consumer got here first
+    }
+}
+
+/*
+* Constructor with assignment to _capacity.
+*
+* Parameter:
+* - capacity: Minimum number of objects the queue can hold.
+*/
+template <typename T>
+MPMCQ<T>::MPMCQ(unsigned int capacity)
+{
+    _capacity = round_up(capacity);
+    _mask = _capacity - 1;
+    _slots = new Slot[_capacity];
+
+    for (std::size_t i = 0; i < _capacity; i++)
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+}
+
+/*
+* Destructor.
+* Must not run while any thread is still using the queue.
+*/
+template <typename T>
+MPMCQ<T>::~MPMCQ()
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+
+        for (; head != tail; head++)
+            object(&_slots[head & _mask])->~T();
+    }
+
+    delete[] _slots;
+}
+
+/*
+* Copy a new object into the queue.
+*
+* Parameter:
+* - data: Object to be added to the end of queue.
+*/
+template <typename T>
+void MPMCQ<T>::enqueue(const T& data)
+{
+    if (!try_emplace(data))
+        throw std::runtime_error("Queue is full.");
+}
+
+/*
+* Move a new object into the queue.
+*
+* Parameter:
+* - data: Object to be moved to the end of queue.
+*/
+template <typename T>
+void MPMCQ<T>::enqueue(T&& data)
+{
+    if (!try_emplace(std::move(data)))
+        throw std::runtime_error("Queue is full.");
+}
+
+/*
+* Remove the first object from the queue.
+*
+* Returns:
+* Removed object.
+*/
+template <typename T>
+T MPMCQ<T>::dequeue()
+{
+    std::size_t pos;
+    Slot* slot = claim_dequeue(pos);
+
+    if (!slot)
+        throw std::runtime_error("Queue is empty.");
+
+    T data = std::move(*object(slot));
+    object(slot)->~T();
+    slot->sequence.store(pos + _capacity, std::memory_order_release);
+    return data;
+}
+
+/*
+* Copy a new object into the queue.
+*
+* Parameter:
+* - data: Object to be added to the end of queue.
+*
+* Returns:
+* False if the queue was full and nothing was added.
+*/
+template <typename T>
+bool MPMCQ<T>::try_enqueue(const T& data)
+{
+    return try_emplace(data);
+}
+
+/*
+* Move a new object into the queue.
+*
+* Parameter:
+* - data: Object to be moved to the end of queue. Untouched on failure.
+*
+* Returns:
+* False if the queue was full and nothing was added.
+*/
+template <typename T>
+bool MPMCQ<T>::try_enqueue(T&& data)
+{
+    return try_emplace(std::move(data));
+}
+
+/*
+* Construct a new object at the end of the queue.
+*
+* If that constructor may throw, the object is built first and then moved
+* into the slot, so a throw leaves the queue untouched.
+*
+* Parameter:
+* - args: Arguments forwarded to a constructor of T.
+*
+* Returns:
+* False if the queue was full and nothing was added.
+*/
+template <typename T>
+template <typename... Args>
+bool MPMCQ<T>::try_emplace(Args&&... args)
+{
+    if constexpr (!std::is_nothrow_constructible<T, Args&&...>::value)
+        return try_emplace(T(std::forward<Args>(args)...));
+    else
+    {
+        std::size_t pos;
+        Slot* slot = claim_enqueue(pos);
+
+        if (!slot)
+            return false;
+
+        new (slot->storage) T(std::forward<Args>(args)...);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+}
+
+/*
+* Remove the first object from the queue.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the queue was empty.
+*/
+template <typename T>
+bool MPMCQ<T>::try_dequeue(T& data)
+{
+    std::size_t pos;
+    Slot* slot = claim_dequeue(pos);
+
+    if (!slot)
+        return false;
+
+    if constexpr (std::is_nothrow_move_assignable<T>::value)
+    {
+        data = std::move(*object(slot));
+        object(slot)->~T();
+        slot->sequence.store(pos + _capacity, std::memory_order_release);
+    }
+    else
+    {
+        // Release the slot before the assignment that may throw
+        T removed = std::move(*object(slot));
+        object(slot)->~T();
+        slot->sequence.store(pos + _capacity, std::memory_order_release);
+        data = std::move(removed);
+    }
+    return true;
+}
+
+/*
+* Returns:
+* Number of objects in the queue. Exact only when no thread is mid-operation.
+*/
+template <typename T>
+unsigned int MPMCQ<T>::getSize() const
+{
+    std::size_t head = _head.load(std::memory_order_acquire);
+    std::size_t tail = _tail.load(std::memory_order_acquire);
+    return tail > head ? (unsigned int)(tail - head) : 0;
+}
+
+/*
+* Returns:
+* Capacity of the queue.
+*/
+template <typename T>
+unsigned int MPMCQ<T>::getMaxCapacity() const
+{
+    return (unsigned int)_capacity;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+
+// ResizePolicy describes when ABS and ABQ grow and shrink their dynamic arrays.
+// Growing happens when the array is full; shrinking waits until occupancy drops
+// well below the growth point so that a size oscillating around a power of two
+// does not reallocate on every operation.
+struct ResizePolicy
+{
+    float scale_factor = 2.0f;                  // Factor for growing and shrinking _capacity
+    float shrink_ratio = 0.25f;                 // Shrink once size / capacity < shrink_ratio (0 = never shrink)
+    unsigned int min_capacity = 1;              // Capacity is never shrunk below this floor
+
+    // Presets
+    static ResizePolicy never_shrink();         // Grow as needed, never give memory back
+    static ResizePolicy eager();                // Original behavior: shrink as soon as size / capacity < 1 / scale_factor
+
+    // Behaviors
+    unsigned int grow(unsigned int capacity) const;                         // Capacity after growing a full array, throws if at the limit
+    bool should_shrink(unsigned int size, unsigned int capacity) const;     // True if the array should shrink
+    unsigned int shrink(unsigned int size, unsigned int capacity) const;    // Capacity after shrinking
+};
+
+/*
+* Returns:
+* Policy that never shrinks the array.
+*/
+inline ResizePolicy ResizePolicy::never_shrink()
+{
+    ResizePolicy policy;
+    policy.shrink_ratio = 0.0f;
+    return policy;
+}
+
+/*
+* Returns:
+* Policy that halves the array as soon as it drops below half full.
+*/
+inline ResizePolicy ResizePolicy::eager()
+{
+    ResizePolicy policy;
+    policy.shrink_ratio = 1 / policy.scale_factor;
+    return policy;
+}
+
+/*
+* Parameter:
+* - capacity: Current capacity of a full array.
+*
+* Returns:
+* capacity * scale_factor, and always at least (capacity + 1).
+* Clamped to the largest unsigned int; throws length_error if capacity is
+* already there.
+*/
+inline unsigned int ResizePolicy::grow(unsigned int capacity) const
+{
+    const unsigned int max = std::numeric_limits<unsigned int>::max();
+
+    if (capacity == max)
+        throw std::length_error("Capacity cannot grow any further.");
+
+    double grown = (double)capacity * scale_factor;
+    if (grown >= (double)max)
+        return max;
+    return grown > capacity + 1.0 ? (unsigned int)grown : capacity + 1;
+}
+
+/*
+* Parameters:
+* - size: Number of objects stored in the array.
+* - capacity: Current capacity of the array.
+*
+* Returns:
+* True if (size / capacity < shrink_ratio) and the array is above min_capacity.
+*/
+inline bool ResizePolicy::should_shrink(unsigned int size, unsigned int capacity) const
+{
+    if (capacity <= 1 || capacity <= min_capacity)
+        return false;
+
+    return (float)size / (float)capacity < shrink_ratio;
+}
+
+/*
+* Parameters:
+* - size: Number of objects stored in the array.
+* - capacity: Current capacity of the array.
+*
+* Returns:
+* capacity / scale_factor, clamped so it never drops below size, min_capacity or 1.
+*/
+inline unsigned int ResizePolicy::shrink(unsigned int size, unsigned int capacity) const
+{
+    unsigned int shrunk = capacity / scale_factor;
+
+    if (shrunk < size)
+        shrunk = size;
+    if (shrunk < min_capacity)
+        shrunk = min_capacity;
+    if (shrunk < 1)
+        shrunk = 1;
+
+    return shrunk;
+}
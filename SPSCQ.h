@@ -0,0 +1,239 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "CacheLine.h"
+
+// SPSCQ class is a bounded ring buffer for passing objects from exactly one
+// producer thread to exactly one consumer thread without locks.
+//
+// The producer owns _tail and the consumer owns _head. Each side publishes its
+// index with a release store and reads the other side's index with an acquire
+// load, but only when its cached copy says the queue looks full (producer) or
+// empty (consumer), so the shared cache lines are touched rarely.
+template <typename T>
+class SPSCQ                                     // Single-producer/single-consumer queue
+{
+private:
+    // Shared, read-only after construction
+    alignas(CACHE_LINE_SIZE) T* _data;          // Ring storage (slots in [_head, _tail) are constructed)
+    std::size_t _capacity;                      // Number of slots, always a power of two
+    std::size_t _mask;                          // _capacity - 1, for wrapping an index into _data
+
+    // Consumer side
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head; // Next slot to dequeue
+    std::size_t _tail_cache;                    // Consumer's last observed value of _tail
+
+    // Producer side
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail; // Next slot to enqueue
+    std::size_t _head_cache;                    // Producer's last observed value of _head
+
+    // Private behaviors
+    static std::size_t round_up(unsigned int capacity); // Smallest power of two >= capacity
+
+public:
+    // Constructors
+    SPSCQ(unsigned int capacity);               // Constructor with specified capacity (rounded up to a power of two)
+    SPSCQ(const SPSCQ& rhs) = delete;           // Not copyable: indices are owned by running threads
+    SPSCQ& operator=(const SPSCQ& rhs) = delete;
+
+    ~SPSCQ();                                   // Destructor
+
+    // Producer behaviors
+    bool try_enqueue(const T& data);            // Copy onto queue, false if full
+    bool try_enqueue(T&& data);                 // Move onto queue, false if full
+    template <typename... Args>
+    bool try_emplace(Args&&... args);           // Construct onto queue from args, false if full
+
+    // Consumer behaviors
+    bool try_dequeue(T& data);                  // Move first item into data, false if empty
+    T* peek();                                  // Pointer to first item, nullptr if empty
+
+    // Accessors
+    unsigned int getSize() const;               // Approximate size when called concurrently
+    unsigned int getMaxCapacity() const;        // _capacity getter
+};
+
+/*
+* Helper function.
+* Rounds capacity up to the next power of two so indices wrap with a mask.
+*
+* Parameter:
+* - capacity: Requested capacity.
+*/
+template <typename T>
+std::size_t SPSCQ<T>::round_up(unsigned int capacity)
+{
+    std::size_t rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    return rounded;
+}
+
+/*
+* Constructor with assignment to _capacity.
+*
+* Parameter:
+* - capacity: Minimum number of objects the queue can hold.
+*/
+template <typename T>
+SPSCQ<T>::SPSCQ(unsigned int capacity)
+{
+    _capacity = round_up(capacity);
+    _mask = _capacity - 1;
+    _data = std::allocator<T>().allocate(_capacity);
+
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _head_cache = 0;
+    _tail_cache = 0;
+}
+
+/*
+* Destructor.
+* Must not run while either thread is still using the queue.
+*/
+template <typename T>
+SPSCQ<T>::~SPSCQ()
+{
+    std::size_t head = _head.load(std::memory_order_relaxed);
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        for (; head != tail; head++)
+            _data[head & _mask].~T();
+    }
+
+    std::allocator<T>().deallocate(_data, _capacity);
+}
+
+/*
+* Copy a new object into the queue. Producer thread only.
+*
+* Parameter:
+* - data: Object to be added to the end of queue.
+*
+* Returns:
+* False if the queue was full and nothing was added.
+*/
+template <typename T>
+bool SPSCQ<T>::try_enqueue(const T& data)
+{
+    return try_emplace(data);
+}
+
+/*
+* Move a new object into the queue. Producer thread only.
+*
+* Parameter:
+* - data: Object to be moved to the end of queue. Untouched on failure.
+*
+* Returns:
+* False if the queue was full and nothing was added.
+*/
+template <typename T>
+bool SPSCQ<T>::try_enqueue(T&& data)
+{
+    return try_emplace(std::move(data));
+}
+
+/*
+* Construct a new object at the end of the queue. Producer thread only.
+*
+* Parameter:
+* - args: Arguments forwarded to a constructor of T.
+*
+* Returns:
+* False if the queue was full and nothing was constructed.
+*/
+template <typename T>
+template <typename... Args>
+bool SPSCQ<T>::try_emplace(Args&&... args)
+{
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+
+    // Only re-read the consumer's index when the cached one says we are full
+    if (tail - _head_cache == _capacity)
+    {
+        _head_cache = _head.load(std::memory_order_acquire);
+        if (tail - _head_cache == _capacity)
+            return false;
+    }
+
+    new (_data + (tail & _mask)) T(std::forward<Args>(args)...);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/*
+* Remove the first object from the queue. Consumer thread only.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the queue was empty.
+*/
+template <typename T>
+bool SPSCQ<T>::try_dequeue(T& data)
+{
+    T* first = peek();
+    if (!first)
+        return false;
+
+    data = std::move(*first);
+    first->~T();
+    _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+}
+
+/*
+* View the first object in the queue. Consumer thread only.
+* The pointer stays valid until the consumer dequeues it.
+*
+* Returns:
+* Pointer to the first object, or nullptr if the queue is empty.
+*/
+template <typename T>
+T* SPSCQ<T>::peek()
+{
+    std::size_t head = _head.load(std::memory_order_relaxed);
+
+    // Only re-read the producer's index when the cached one says we are empty
+    if (head == _tail_cache)
+    {
+        _tail_cache = _tail.load(std::memory_order_acquire);
+        if (head == _tail_cache)
+            return nullptr;
+    }
+
+    return _data + (head & _mask);
+}
+
+/*
+* Returns:
+* Number of objects in the queue. Exact only when both threads are idle.
+*/
+template <typename T>
+unsigned int SPSCQ<T>::getSize() const
+{
+    std::size_t head = _head.load(std::memory_order_acquire);
+    std::size_t tail = _tail.load(std::memory_order_acquire);
+    return (unsigned int)(tail - head);
+}
+
+/*
+* Returns:
+* Capacity of the queue.
+*/
+template <typename T>
+unsigned int SPSCQ<T>::getMaxCapacity() const
+{
+    return (unsigned int)_capacity;
+}
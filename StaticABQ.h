@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+// StaticABQ class is an array-based circular queue whose capacity is fixed at
+// compile time. Storage is a std::array inside the object, so it never
+// allocates and never resizes. Every member is constexpr, so a StaticABQ can be
+// built and used in constant expressions.
+//
+// _head and _tail count every dequeue and enqueue and are allowed to wrap
+// around unsigned int. Capacity must be a power of two, so a slot is found with
+// position & MASK instead of ABQ's compare-and-subtract wrap, and the size is
+// simply _tail - _head.
+//
+// Slots outside the live range hold default-constructed or moved-from
+// objects, so T must be default constructible and move assignable.
+template <typename T, unsigned int Capacity>
+class StaticABQ                                 // Fixed-capacity array-based queue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+        "StaticABQ requires a power-of-two capacity");
+
+private:
+    static constexpr unsigned int MASK = Capacity - 1; // Turns a position into a slot index
+
+    // Member variables
+    std::array<T, Capacity> _data;              // Data stored in the queue
+    unsigned int _head;                         // Position of the next object to dequeue
+    unsigned int _tail;                         // Position of the next free slot
+
+public:
+    // Constructors
+    constexpr StaticABQ();                      // Default constructor
+
+    // Behaviors
+    constexpr void enqueue(const T& data);      // Copy onto queue, throws if full
+    constexpr void enqueue(T&& data);           // Move onto queue, throws if full
+    constexpr bool try_enqueue(const T& data);  // Copy onto queue, false if full
+    constexpr T dequeue();                      // Remove and return first item in queue, throws if empty
+    constexpr bool try_dequeue(T& data);        // Move first item into data, false if empty
+    constexpr void clear();                     // Remove every object
+
+    // Accessors
+    constexpr const T& peek() const;            // Return first item in queue
+    constexpr unsigned int getSize() const;     // Number of objects in the queue
+    static constexpr unsigned int getMaxCapacity(); // Capacity getter
+    constexpr const T* getData() const;         // _data getter
+};
+
+/*
+* Default constructor.
+*/
+template <typename T, unsigned int Capacity>
+constexpr StaticABQ<T, Capacity>::StaticABQ() : _data(), _head(0), _tail(0)
+{
+}
+
+/*
+* Add a new object to the back of the queue.
+*
+* Parameter:
+* - data: Object to be copied in.
+*/
+template <typename T, unsigned int Capacity>
+constexpr void StaticABQ<T, Capacity>::enqueue(const T& data)
+{
+    if (_tail - _head == Capacity)
+        throw std::runtime_error("Queue is full.");
+
+    _data[_tail++ & MASK] = data;
+}
+
+/*
+* Add a new object to the back of the queue.
+*
+* Parameter:
+* - data: Object to be moved in.
+*/
+template <typename T, unsigned int Capacity>
+constexpr void StaticABQ<T, Capacity>::enqueue(T&& data)
+{
+    if (_tail - _head == Capacity)
+        throw std::runtime_error("Queue is full.");
+
+    _data[_tail++ & MASK] = std::move(data);
+}
+
+/*
+* Add a new object to the back of the queue unless it is full.
+*
+* Parameter:
+* - data: Object to be copied in.
+*
+* Returns:
+* False if the queue was full.
+*/
+template <typename T, unsigned int Capacity>
+constexpr bool StaticABQ<T, Capacity>::try_enqueue(const T& data)
+{
+    if (_tail - _head == Capacity)
+        return false;
+
+    _data[_tail++ & MASK] = data;
+    return true;
+}
+
+/*
+* Remove the object at the front of the queue.
+*
+* Returns:
+* The removed object.
+*/
+template <typename T, unsigned int Capacity>
+constexpr T StaticABQ<T, Capacity>::dequeue()
+{
+    if (_tail == _head)
+        throw std::runtime_error("Queue is empty.");
+
+    return std::move(_data[_head++ & MASK]);
+}
+
+/*
+* Remove the object at the front of the queue unless it is empty.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the queue was empty.
+*/
+template <typename T, unsigned int Capacity>
+constexpr bool StaticABQ<T, Capacity>::try_dequeue(T& data)
+{
+    if (_tail == _head)
+        return false;
+
+    data = std::move(_data[_head++ & MASK]);
+    return true;
+}
+
+/*
+* Remove every object. The slots keep their last values until overwritten.
+*/
+template <typename T, unsigned int Capacity>
+constexpr void StaticABQ<T, Capacity>::clear()
+{
+    _head = _tail;
+}
+
+/*
+* Returns:
+* The object at the front of the queue.
+*/
+template <typename T, unsigned int Capacity>
+constexpr const T& StaticABQ<T, Capacity>::peek() const
+{
+    if (_tail == _head)
+        throw std::runtime_error("Queue is empty.");
+
+    return _data[_head & MASK];
+}
+
+/*
+* Returns:
+* Number of objects in the queue.
+*/
+template <typename T, unsigned int Capacity>
+constexpr unsigned int StaticABQ<T, Capacity>::getSize() const
+{
+    return _tail - _head;
+}
+
+/*
+* Returns:
+* Capacity, fixed by the template parameter.
+*/
+template <typename T, unsigned int Capacity>
+constexpr unsigned int StaticABQ<T, Capacity>::getMaxCapacity()
+{
+    return Capacity;
+}
+
+/*
+* Returns:
+* Pointer to the first slot. Objects are stored from getData()[_head & MASK],
+* wrapping at the end of the array.
+*/
+template <typename T, unsigned int Capacity>
+constexpr const T* StaticABQ<T, Capacity>::getData() const
+{
+    return _data.data();
+}
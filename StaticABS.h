@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+// StaticABS class is an array-based stack whose capacity is fixed at compile
+// time. Storage is a std::array inside the object, so it never allocates, has
+// no _data pointer or _capacity member, and never resizes. Every member is
+// constexpr, so a StaticABS can be built and used in constant expressions.
+//
+// Slots outside [0, _size) hold default-constructed or moved-from objects,
+// so T must be default constructible and move assignable.
+template <typename T, unsigned int Capacity>
+class StaticABS                                 // Fixed-capacity array-based stack
+{
+    static_assert(Capacity > 0, "StaticABS requires a capacity of at least 1");
+
+private:
+    // Member variables
+    std::array<T, Capacity> _data;              // Data stored in the stack
+    unsigned int _size;                         // Current size of the stack
+
+public:
+    // Constructors
+    constexpr StaticABS();                      // Default constructor
+
+    // Behaviors
+    constexpr void push(const T& data);         // Copy onto stack, throws if full
+    constexpr void push(T&& data);              // Move onto stack, throws if full
+    constexpr bool try_push(const T& data);     // Copy onto stack, false if full
+    constexpr T pop();                          // Remove and return last item in stack, throws if empty
+    constexpr bool try_pop(T& data);            // Move last item into data, false if empty
+    constexpr void clear();                     // Remove every object
+
+    // Accessors
+    constexpr const T& peek() const;            // Return last item in stack
+    constexpr unsigned int getSize() const;     // _size getter
+    static constexpr unsigned int getMaxCapacity(); // Capacity getter
+    constexpr const T* getData() const;         // _data getter
+};
+
+/*
+* Default constructor.
+*/
+template <typename T, unsigned int Capacity>
+constexpr StaticABS<T, Capacity>::StaticABS() : _data(), _size(0)
+{
+}
+
+/*
+* Add a new object to the top of the stack.
+*
+* Parameter:
+* - data: Object to be copied in.
+*/
+template <typename T, unsigned int Capacity>
+constexpr void StaticABS<T, Capacity>::push(const T& data)
+{
+    if (_size == Capacity)
+        throw std::runtime_error("Stack is full.");
+
+    _data[_size++] = data;
+}
+
+/*
+* Add a new object to the top of the stack.
+*
+* Parameter:
+* - data: Object to be moved in.
+*/
+template <typename T, unsigned int Capacity>
+constexpr void StaticABS<T, Capacity>::push(T&& data)
+{
+    if (_size == Capacity)
+        throw std::runtime_error("Stack is full.");
+
+    _data[_size++] = std::move(data);
+}
+
+/*
+* Add a new object to the top of the stack unless it is full.
+*
+* Parameter:
+* - data: Object to be copied in.
+*
+* Returns:
+* False if the stack was full.
+*/
+template <typename T, unsigned int Capacity>
+constexpr bool StaticABS<T, Capacity>::try_push(const T& data)
+{
+    if (_size == Capacity)
+        return false;
+
+    _data[_size++] = data;
+    return true;
+}
+
+/*
+* Remove the last object pushed.
+*
+* Returns:
+* The removed object.
+*/
+template <typename T, unsigned int Capacity>
+constexpr T StaticABS<T, Capacity>::pop()
+{
+    if (_size == 0)
+        throw std::runtime_error("Stack is empty.");
+
+    return std::move(_data[--_size]);
+}
+
+/*
+* Remove the last object pushed unless the stack is empty.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the stack was empty.
+*/
+template <typename T, unsigned int Capacity>
+constexpr bool StaticABS<T, Capacity>::try_pop(T& data)
+{
+    if (_size == 0)
+        return false;
+
+    data = std::move(_data[--_size]);
+    return true;
+}
+
+/*
+* Remove every object. The slots keep their last values until overwritten.
+*/
+template <typename T, unsigned int Capacity>
+constexpr void StaticABS<T, Capacity>::clear()
+{
+    _size = 0;
+}
+
+/*
+* Returns:
+* The last object pushed.
+*/
+template <typename T, unsigned int Capacity>
+constexpr const T& StaticABS<T, Capacity>::peek() const
+{
+    if (_size == 0)
+        throw std::runtime_error("Stack is empty.");
+
+    return _data[_size - 1];
+}
+
+/*
+* Returns:
+* Number of objects in the stack.
+*/
+template <typename T, unsigned int Capacity>
+constexpr unsigned int StaticABS<T, Capacity>::getSize() const
+{
+    return _size;
+}
+
+/*
+* Returns:
+* Capacity, fixed by the template parameter.
+*/
+template <typename T, unsigned int Capacity>
+constexpr unsigned int StaticABS<T, Capacity>::getMaxCapacity()
+{
+    return Capacity;
+}
+
+/*
+* Returns:
+* Pointer to the first slot.
+*/
+template <typename T, unsigned int Capacity>
+constexpr const T* StaticABS<T, Capacity>::getData() const
+{
+    return _data.data();
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "CacheLine.h"
+
+// WSD class is a Chase-Lev work-stealing deque. One owner thread pushes and
+// pops at the bottom like ABS::push()/pop(), while any number of thief threads
+// steal from the top like ABQ::dequeue(). The memory orders follow Le, Pop,
+// Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (PPoPP 2013).
+//
+// The ring grows by SCALE_FACTOR when the owner finds it full. A thief may
+// still be reading the old ring at that moment, so replaced rings are kept on
+// a retired list and freed when the deque is destroyed.
+//
+// Thieves read a slot before they know whether their steal will succeed, so
+// slots are std::atomic<T> and T must be trivially copyable (typically a
+// pointer or small handle to a task).
+template <typename T>
+class WSD                                       // Work-stealing deque
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+        "WSD requires a trivially copyable T");
+
+private:
+    struct Ring
+    {
+        std::int64_t capacity;                  // Number of slots, always a power of two
+        std::atomic<T>* data;                   // Slots, indexed by position & (capacity - 1)
+        Ring* retired;                          // Ring this one replaced, freed in destructor
+
+        Ring(std::int64_t capacity, Ring* retired);
+        ~Ring();
+        T get(std::int64_t index) const;        // Relaxed read of a slot
+        void put(std::int64_t index, T data);   // Relaxed write of a slot
+    };
+
+    static constexpr std::int64_t SCALE_FACTOR = 2; // Factor for growing the ring
+
+    // Member variables
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> _top; // Next position to steal
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> _bottom; // Next position to push
+    std::atomic<Ring*> _ring;                   // Current ring
+
+    // Private behaviors
+    Ring* increase_capacity(Ring* ring, std::int64_t top, std::int64_t bottom); // Copy live items into a larger ring
+
+public:
+    // Constructors
+    WSD(unsigned int capacity);                 // Constructor with specified capacity (rounded up to a power of two)
+    WSD(const WSD& rhs) = delete;               // Not copyable: shared with running threads
+    WSD& operator=(const WSD& rhs) = delete;
+
+    ~WSD();                                     // Destructor
+
+    // Owner behaviors
+    void push(T data);                          // Add to bottom of deque
+    bool try_pop(T& data);                      // Remove last item pushed, false if empty
+
+    // Thief behaviors
+    bool steal(T& data);                        // Remove oldest item, false if empty or lost a race
+
+    // Accessors
+    unsigned int getSize() const;               // Approximate size when called concurrently
+    unsigned int getMaxCapacity() const;        // Capacity of the current ring
+};
+
+/*
+* Ring constructor.
+*
+* Parameters:
+* - capacity: Number of slots. Must be a power of two.
+* - retired: Ring being replaced, or nullptr.
+*/
+template <typename T>
+WSD<T>::Ring::Ring(std::int64_t capacity, Ring* retired)
+{
+    this->capacity = capacity;
+    this->retired = retired;
+    data = new std::atomic<T>[capacity];
+}
+
+/*
+* Ring destructor. Frees every ring this one replaced as well.
+*/
+template <typename T>
+WSD<T>::Ring::~Ring()
+{
+    delete[] data;
+    delete retired;
+}
+
+/*
+* Returns:
+* Object in the slot for position index.
+*/
+template <typename T>
+T WSD<T>::Ring::get(std::int64_t index) const
+{
+    return data[index & (capacity - 1)].load(std::memory_order_relaxed);
+}
+
+/*
+* Stores data in the slot for position index.
+*/
+template <typename T>
+void WSD<T>::Ring::put(std::int64_t index, T data)
+{
+    this->data[index & (capacity - 1)].store(data, std::memory_order_relaxed);
+}
+
+/*
+* Helper function.
+* Copies the live range [top, bottom) into a ring SCALE_FACTOR times larger
+* and publishes it. Owner thread only.
+*
+* Returns:
+* The new ring.
+*/
+template <typename T>
+typename WSD<T>::Ring* WSD<T>::increase_capacity(Ring* ring, std::int64_t top, std::int64_t bottom)
+{
+    Ring* resized = new Ring(ring->capacity * SCALE_FACTOR, ring);
+
+    // Positions are kept, only their slot in the ring changes
+    for (std::int64_t i = top; i < bottom; i++)
+        resized->put(i, ring->get(i));
+
+    _ring.store(resized, std::memory_order_release);
+    return resized;
+}
+
+/*
+* Constructor with assignment to capacity.
+*
+* Parameter:
+* - capacity: Initial number of slots.
+*/
+template <typename T>
+WSD<T>::WSD(unsigned int capacity)
+{
+    std::int64_t rounded = 1;
+    while (rounded < capacity)
+        rounded *= SCALE_FACTOR;
+
+    _top.store(0, std::memory_order_relaxed);
+    _bottom.store(0, std::memory_order_relaxed);
+    _ring.store(new Ring(rounded, nullptr), std::memory_order_relaxed);
+}
+
+/*
+* Destructor.
+* Must not run while any thread is still using the deque.
+*/
+template <typename T>
+WSD<T>::~WSD()
+{
+    delete _ring.load(std::memory_order_relaxed);
+}
+
+/*
+* Add a new object to the bottom of the deque. Owner thread only.
+* If necessary, resize the ring to make room for the new object.
+*
+* Parameter:
+* - data: Object to be added.
+*/
+template <typename T>
+void WSD<T>::push(T data)
+{
+    std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    std::int64_t top = _top.load(std::memory_order_acquire);
+    Ring* ring = _ring.load(std::memory_order_relaxed);
+
+    if (bottom - top > ring->capacity - 1)
+        ring = increase_capacity(ring, top, bottom);
+
+    ring->put(bottom, data);
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+/*
+* Remove the most recently pushed object. Owner thread only.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the deque was empty or a thief took the last object.
+*/
+template <typename T>
+bool WSD<T>::try_pop(T& data)
+{
+    std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    Ring* ring = _ring.load(std::memory_order_relaxed);
+
+    // Claim the bottom slot before looking at top, so a concurrent thief
+    // either sees the claim or we see its steal
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = _top.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    T item = ring->get(bottom);
+
+    // Last object: race the thieves for it through top
+    if (top == bottom)
+    {
+        bool won = _top.compare_exchange_strong(top, top + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+
+        if (!won)
+            return false;
+    }
+
+    data = item;
+    return true;
+}
+
+/*
+* Remove the oldest object. Any thread.
+*
+* Parameter:
+* - data: Receives the removed object. Untouched on failure.
+*
+* Returns:
+* False if the deque was empty or another thread took the object first.
+*/
+template <typename T>
+bool WSD<T>::steal(T& data)
+{
+    std::int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = _bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+        return false;
+
+    T item = _ring.load(std::memory_order_acquire)->get(top);
+
+    if (!_top.compare_exchange_strong(top, top + 1,
+        std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false;
+
+    data = item;
+    return true;
+}
+
+/*
+* Returns:
+* Number of objects in the deque. Exact only when no thread is mid-operation.
+*/
+template <typename T>
+unsigned int WSD<T>::getSize() const
+{
+    std::int64_t bottom = _bottom.load(std::memory_order_acquire);
+    std::int64_t top = _top.load(std::memory_order_acquire);
+    return bottom > top ? (unsigned int)(bottom - top) : 0;
+}
+
+/*
+* Returns:
+* Capacity of the current ring.
+*/
+template <typename T>
+unsigned int WSD<T>::getMaxCapacity() const
+{
+    return (unsigned int)_ring.load(std::memory_order_acquire)->capacity;
+}
@@ -0,0 +1,339 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+#include <deque>
+#include <stack>
+#include <queue>
+#include <algorithm>
+#include <iterator>
+#include "ABS.h"
+#include "ABQ.h"
+using namespace std;
+
+// Micro-benchmark suite for ABS and ABQ against std::vector, std::deque,
+// std::stack and std::queue, in the spirit of Google Benchmark: every
+// workload runs for each element type, container and size, and prints one row.
+//
+// Workloads:
+// - push_pop:      fill a stack to size, then drain it
+// - enqueue_deq:   fill a queue to size, then drain it
+// - oscillate:     fill to size, then repeatedly drain to size/8 and refill,
+//                  which crosses the shrink threshold of ResizePolicy each time
+// - bulk_stack:    the same as push_pop in chunks of 64 (push_range/pop_range)
+// - bulk_queue:    the same as enqueue_deq in chunks of 64 (enqueue_n/dequeue_n)
+//
+// Columns:
+// - ns/op:         wall time per element pushed or popped
+// - allocs/op:     calls to operator new per element pushed or popped
+// - copied B/op:   bytes moved from an old array into a new one by
+//                  reallocations, per element pushed or popped, measured in a
+//                  separate untimed pass of the same container and element
+//                  type (so the same memcpy or element-wise path as timed)
+//
+// Usage: a.out [max size] [filter]
+//   max size:  largest size to run, from 10 up to 10^8 (default 10^6)
+//   filter:    only run benchmarks whose name contains this text
+//
+// Build: g++ -std=c++17 -O2 bench_ABS_ABQ.cpp
+
+using Clock = chrono::steady_clock;
+
+const uint64_t OPS_PER_RUN = 4000000;           // Rounds are repeated until about this many ops
+const unsigned int CHUNK = 64;                  // Objects per call in the bulk workloads
+
+// Allocation counting: every container here allocates through the global operator new
+static uint64_t allocations = 0;
+
+void* operator new(size_t size)
+{
+	allocations++;
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+struct Blob                                     // 64-byte trivially copyable payload
+{
+	uint64_t words[8];
+};
+
+// Element types: values and names
+template <typename T> T make(unsigned int i);
+template <> int make<int>(unsigned int i) { return (int)i; }
+template <> float make<float>(unsigned int i) { return (float)i; }
+template <> string make<string>(unsigned int i) { return to_string(i % 100000); } // Short enough for SSO
+template <> Blob make<Blob>(unsigned int i) { Blob b = {}; b.words[0] = i; return b; }
+
+template <typename T> const char* type_name();
+template <> const char* type_name<int>() { return "int"; }
+template <> const char* type_name<float>() { return "float"; }
+template <> const char* type_name<string>() { return "string"; }
+template <> const char* type_name<Blob>() { return "Blob64"; }
+
+// Uniform stack and queue interface over every container
+template <typename T> void push(ABS<T>& c, const T& v) { c.push(v); }
+template <typename T> T pop(ABS<T>& c) { return c.pop(); }
+template <typename T> void push(vector<T>& c, const T& v) { c.push_back(v); }
+template <typename T> T pop(vector<T>& c) { T v = std::move(c.back()); c.pop_back(); return v; }
+template <typename T> void push(stack<T>& c, const T& v) { c.push(v); }
+template <typename T> T pop(stack<T>& c) { T v = std::move(c.top()); c.pop(); return v; }
+
+template <typename T> void push(ABQ<T>& c, const T& v) { c.enqueue(v); }
+template <typename T> T pop(ABQ<T>& c) { return c.dequeue(); }
+template <typename T> void push(deque<T>& c, const T& v) { c.push_back(v); }
+template <typename T> T pop(deque<T>& c) { T v = std::move(c.front()); c.pop_front(); return v; }
+template <typename T> void push(queue<T>& c, const T& v) { c.push(v); }
+template <typename T> T pop(queue<T>& c) { T v = std::move(c.front()); c.pop(); return v; }
+
+template <typename T> void push_n(ABS<T>& c, const T* v, unsigned int n) { c.push_range(v, n); }
+template <typename T> void pop_n(ABS<T>& c, T* v, unsigned int n) { c.pop_range(v, n); }
+template <typename T> void push_n(vector<T>& c, const T* v, unsigned int n) { c.insert(c.end(), v, v + n); }
+template <typename T> void pop_n(vector<T>& c, T* v, unsigned int n)
+{
+	move(c.end() - n, c.end(), v);
+	c.erase(c.end() - n, c.end());
+}
+
+template <typename T> void push_n(ABQ<T>& c, const T* v, unsigned int n) { c.enqueue_n(v, n); }
+template <typename T> void pop_n(ABQ<T>& c, T* v, unsigned int n) { c.dequeue_n(v, n); }
+template <typename T> void push_n(deque<T>& c, const T* v, unsigned int n) { c.insert(c.end(), v, v + n); }
+template <typename T> void pop_n(deque<T>& c, T* v, unsigned int n)
+{
+	move(c.begin(), c.begin() + n, v);
+	c.erase(c.begin(), c.begin() + n);
+}
+
+// Reallocation counting: a container's capacity changes exactly when it
+// moves its objects to a new array, and every object that stays in the
+// container across the call is moved once. deque, stack and queue never move
+// their objects.
+static uint64_t copied_bytes = 0;
+
+template <typename T> size_t capacity_of(const ABS<T>& c) { return c.getMaxCapacity(); }
+template <typename T> size_t capacity_of(const ABQ<T>& c) { return c.getMaxCapacity(); }
+template <typename T> size_t capacity_of(const vector<T>& c) { return c.capacity(); }
+template <typename C> size_t capacity_of(const C&) { return 0; }
+
+template <typename T> size_t size_of(const ABS<T>& c) { return c.getSize(); }
+template <typename T> size_t size_of(const ABQ<T>& c) { return c.getSize(); }
+template <typename C> size_t size_of(const C& c) { return c.size(); }
+
+template <typename C>
+struct Tracked                                  // Container that adds its reallocations to copied_bytes
+{
+	C c;
+	size_t size = 0;                            // Size before the current call
+	size_t capacity = 0;                        // Capacity before the current call
+
+	void before()
+	{
+		size = size_of(c);
+		capacity = capacity_of(c);
+	}
+
+	void after(size_t object_size)
+	{
+		if (capacity_of(c) != capacity)
+			copied_bytes += min(size, size_of(c)) * object_size;
+	}
+};
+
+template <typename C, typename T> void push(Tracked<C>& t, const T& v) { t.before(); push(t.c, v); t.after(sizeof(T)); }
+template <typename C> auto pop(Tracked<C>& t) { t.before(); auto v = pop(t.c); t.after(sizeof(v)); return v; }
+template <typename C, typename T> void push_n(Tracked<C>& t, const T* v, unsigned int n) { t.before(); push_n(t.c, v, n); t.after(sizeof(T)); }
+template <typename C, typename T> void pop_n(Tracked<C>& t, T* v, unsigned int n) { t.before(); pop_n(t.c, v, n); t.after(sizeof(T)); }
+
+// Workloads. Each returns the number of elements pushed plus popped.
+template <typename C, typename T>
+uint64_t fill_drain(C& c, const vector<T>& values, T& sink)
+{
+	for (const T& v : values)
+		push(c, v);
+	for (size_t i = 0; i < values.size(); i++)
+		sink = pop(c);
+	return 2 * values.size();
+}
+
+template <typename C, typename T>
+uint64_t oscillate(C& c, const vector<T>& values, T& sink)
+{
+	size_t low = values.size() / 8;
+	uint64_t ops = 0;
+
+	for (const T& v : values)
+		push(c, v);
+	for (int swing = 0; swing < 4; swing++)
+	{
+		for (size_t i = low; i < values.size(); i++)
+			sink = pop(c);
+		for (size_t i = low; i < values.size(); i++)
+			push(c, values[i]);
+		ops += 2 * (values.size() - low);
+	}
+	for (size_t i = 0; i < values.size(); i++)
+		sink = pop(c);
+
+	return ops + 2 * values.size();
+}
+
+template <typename C, typename T>
+uint64_t bulk(C& c, const vector<T>& values, T& sink)
+{
+	T out[CHUNK] = {};
+	size_t chunks = values.size() / CHUNK;
+
+	for (size_t i = 0; i < chunks; i++)
+		push_n(c, values.data() + i * CHUNK, CHUNK);
+	for (size_t i = 0; i < chunks; i++)
+		pop_n(c, out, CHUNK);
+
+	sink = out[0];
+	return 2 * chunks * CHUNK;
+}
+
+enum Workload { FILL_DRAIN, OSCILLATE, BULK };
+
+// Chosen at compile time so adapters without bulk operations still compile
+template <Workload W, typename C, typename T>
+uint64_t run_once(C& c, const vector<T>& values, T& sink)
+{
+	if constexpr (W == FILL_DRAIN)
+		return fill_drain(c, values, sink);
+	else if constexpr (W == OSCILLATE)
+		return oscillate(c, values, sink);
+	else
+		return bulk(c, values, sink);
+}
+
+struct Result
+{
+	double ns_per_op;
+	double allocs_per_op;
+	double copied_per_op;
+};
+
+// Times rounds of the workload on a fresh container each round, then repeats
+// one round on a Tracked container to measure bytes copied by reallocations
+template <typename T, template <typename...> class Container, Workload W>
+Result measure(unsigned int size)
+{
+	vector<T> values;
+	for (unsigned int i = 0; i < size; i++)
+		values.push_back(make<T>(i));
+
+	T sink = T();
+	uint64_t rounds = max<uint64_t>(1, OPS_PER_RUN / (2ull * size));
+	uint64_t ops = 0;
+
+	allocations = 0;
+	auto start = Clock::now();
+	for (uint64_t round = 0; round < rounds; round++)
+	{
+		Container<T> c;
+		ops += run_once<W>(c, values, sink);
+	}
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+	uint64_t allocated = allocations;
+
+	Tracked<Container<T>> tracked;
+	copied_bytes = 0;
+	uint64_t counted_ops = run_once<W>(tracked, values, sink);
+
+	// Keep the optimizer from discarding the work
+	volatile const void* escape = &sink;
+	(void)escape;
+
+	Result result;
+	result.ns_per_op = ops ? seconds * 1e9 / ops : 0;
+	result.allocs_per_op = ops ? (double)allocated / ops : 0;
+	result.copied_per_op = counted_ops ? (double)copied_bytes / counted_ops : 0;
+	return result;
+}
+
+// std::stack and std::queue take their element type first, like the other containers
+template <typename T> using Stack = stack<T>;
+template <typename T> using Queue = queue<T>;
+template <typename T> using DefaultABS = ABS<T>;
+template <typename T> using DefaultABQ = ABQ<T>;
+template <typename T> using Vector = vector<T>;
+template <typename T> using Deque = deque<T>;
+
+static string filter;
+
+template <typename T, template <typename...> class Container, Workload W>
+void report(const char* workload_name, const char* container_name, unsigned int size)
+{
+	string name = string(workload_name) + "/" + container_name + "<" + type_name<T>() + ">";
+	if (name.find(filter) == string::npos)
+		return;
+
+	Result r = measure<T, Container, W>(size);
+	cout << left << setw(40) << name << right << setw(11) << size
+		<< fixed << setprecision(2) << setw(11) << r.ns_per_op
+		<< setprecision(4) << setw(12) << r.allocs_per_op
+		<< setprecision(1) << setw(13) << r.copied_per_op << "\n";
+}
+
+template <typename T>
+void run_type(unsigned int size)
+{
+	report<T, DefaultABS, FILL_DRAIN>("push_pop", "ABS", size);
+	report<T, Vector, FILL_DRAIN>("push_pop", "vector", size);
+	report<T, Stack, FILL_DRAIN>("push_pop", "stack", size);
+
+	report<T, DefaultABQ, FILL_DRAIN>("enqueue_deq", "ABQ", size);
+	report<T, Deque, FILL_DRAIN>("enqueue_deq", "deque", size);
+	report<T, Queue, FILL_DRAIN>("enqueue_deq", "queue", size);
+
+	report<T, DefaultABS, OSCILLATE>("oscillate", "ABS", size);
+	report<T, Vector, OSCILLATE>("oscillate", "vector", size);
+	report<T, DefaultABQ, OSCILLATE>("oscillate", "ABQ", size);
+	report<T, Deque, OSCILLATE>("oscillate", "deque", size);
+
+	if (size < CHUNK)
+		return;
+
+	report<T, DefaultABS, BULK>("bulk_stack", "ABS", size);
+	report<T, Vector, BULK>("bulk_stack", "vector", size);
+	report<T, DefaultABQ, BULK>("bulk_queue", "ABQ", size);
+	report<T, Deque, BULK>("bulk_queue", "deque", size);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int max_size = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 10) : 1000000;
+	if (argc > 2)
+		filter = argv[2];
+
+	cout << left << setw(40) << "Benchmark" << right << setw(11) << "Size" << setw(11) << "ns/op"
+		<< setw(12) << "allocs/op" << setw(13) << "copied B/op" << "\n";
+	cout << string(87, '-') << "\n";
+
+	for (unsigned int size = 10; size <= max_size; size *= 10)
+	{
+		run_type<int>(size);
+		run_type<float>(size);
+		run_type<string>(size);
+		run_type<Blob>(size);
+
+		if (size > max_size / 10)
+			break;
+	}
+
+	return 0;
+}
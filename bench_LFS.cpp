@@ -0,0 +1,127 @@
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "ABS.h"
+#include "LFS.h"
+using namespace std;
+
+// Benchmark and stress test: 1..N threads share one stack. Every thread pushes
+// a burst of unique values and pops the same number back, so nodes are
+// constantly recycled between threads. The sum of everything popped is checked
+// against the sum of everything pushed.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench_LFS.cpp
+// Under ThreadSanitizer: g++ -std=c++17 -O1 -g -fsanitize=thread -pthread bench_LFS.cpp
+
+using Clock = chrono::steady_clock;
+
+const unsigned int ROUNDS_PER_THREAD = 100000;
+const unsigned int BURST = 8;
+
+// ABS guarded by a mutex
+struct MutexABS
+{
+	ABS<unsigned long> stack;
+	mutex lock;
+
+	void push(unsigned long data)
+	{
+		lock_guard<mutex> guard(lock);
+		stack.push(data);
+	}
+
+	bool try_pop(unsigned long& data)
+	{
+		lock_guard<mutex> guard(lock);
+		if (stack.getSize() == 0)
+			return false;
+		data = stack.pop();
+		return true;
+	}
+};
+
+// Returns total operations per second across all threads, or 0 if values were lost
+template <typename Stack>
+double run(unsigned int threads)
+{
+	Stack stack;
+	atomic<bool> go(false);
+	atomic<unsigned long> pushed(0), popped(0);
+	vector<thread> workers;
+
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		workers.emplace_back([&, t]()
+		{
+			while (!go.load(memory_order_acquire))
+				this_thread::yield();
+
+			unsigned long value = (unsigned long)t * ROUNDS_PER_THREAD * BURST;
+			unsigned long pushed_sum = 0, popped_sum = 0, data;
+
+			for (unsigned int i = 0; i < ROUNDS_PER_THREAD; i++)
+			{
+				for (unsigned int j = 0; j < BURST; j++)
+				{
+					stack.push(++value);
+					pushed_sum += value;
+				}
+				for (unsigned int j = 0; j < BURST; j++)
+				{
+					while (!stack.try_pop(data))
+						this_thread::yield();
+					popped_sum += data;
+				}
+			}
+
+			pushed += pushed_sum;
+			popped += popped_sum;
+		});
+	}
+
+	auto start = Clock::now();
+	go.store(true, memory_order_release);
+	for (thread& worker : workers)
+		worker.join();
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+	unsigned long leftover;
+	if (pushed != popped || stack.try_pop(leftover))
+		return 0;
+
+	return 2.0 * ROUNDS_PER_THREAD * BURST * threads / seconds;
+}
+
+int main()
+{
+	unsigned int cores = thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+
+	cout << "Threads | LFS M ops/sec | Mutex ABS M ops/sec\n";
+
+	// Powers of two up to the core count, always finishing with the full core count
+	vector<unsigned int> counts;
+	for (unsigned int threads = 1; threads < cores; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(cores);
+
+	for (unsigned int threads : counts)
+	{
+		double lock_free = run<LFS<unsigned long>>(threads) / 1e6;
+		double locked = run<MutexABS>(threads) / 1e6;
+
+		if (lock_free == 0 || locked == 0)
+		{
+			cout << "Error: popped values do not match pushed values!\n";
+			return 1;
+		}
+
+		cout << threads << " | " << lock_free << " | " << locked << "\n";
+	}
+
+	return 0;
+}
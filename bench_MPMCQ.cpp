@@ -0,0 +1,114 @@
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "ABQ.h"
+#include "MPMCQ.h"
+using namespace std;
+
+// Benchmark: 1..N threads share one queue. Every thread repeatedly enqueues an
+// item and then dequeues one, so each thread is both a producer and a consumer
+// and contention grows with the thread count.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench_MPMCQ.cpp
+
+using Clock = chrono::steady_clock;
+
+const unsigned int CAPACITY = 1024;
+const unsigned int OPS_PER_THREAD = 2000000;
+
+// ABQ guarded by a mutex, bounded to CAPACITY so both queues apply the same back-pressure
+struct MutexABQ
+{
+	ABQ<unsigned int> queue;
+	mutex lock;
+
+	MutexABQ() : queue(CAPACITY) {}
+
+	bool try_enqueue(unsigned int data)
+	{
+		lock_guard<mutex> guard(lock);
+		if (queue.getSize() == CAPACITY)
+			return false;
+		queue.enqueue(data);
+		return true;
+	}
+
+	bool try_dequeue(unsigned int& data)
+	{
+		lock_guard<mutex> guard(lock);
+		if (queue.getSize() == 0)
+			return false;
+		data = queue.dequeue();
+		return true;
+	}
+};
+
+// Returns total operations per second across all threads
+template <typename Queue>
+double run(unsigned int threads)
+{
+	Queue queue;
+	atomic<bool> go(false);
+	vector<thread> workers;
+
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		workers.emplace_back([&queue, &go, t]()
+		{
+			while (!go.load(memory_order_acquire))
+				this_thread::yield();
+
+			unsigned int data;
+			for (unsigned int i = 0; i < OPS_PER_THREAD; i++)
+			{
+				while (!queue.try_enqueue(t))
+					this_thread::yield();
+				while (!queue.try_dequeue(data))
+					this_thread::yield();
+			}
+		});
+	}
+
+	auto start = Clock::now();
+	go.store(true, memory_order_release);
+	for (thread& worker : workers)
+		worker.join();
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+	// Each iteration is one enqueue and one dequeue
+	return 2.0 * OPS_PER_THREAD * threads / seconds;
+}
+
+struct LockFree : MPMCQ<unsigned int>
+{
+	LockFree() : MPMCQ<unsigned int>(CAPACITY) {}
+};
+
+int main()
+{
+	unsigned int cores = thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+
+	cout << "Threads | MPMCQ M ops/sec (per thread) | Mutex ABQ M ops/sec (per thread)\n";
+
+	// Powers of two up to the core count, always finishing with the full core count
+	vector<unsigned int> counts;
+	for (unsigned int threads = 1; threads < cores; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(cores);
+
+	for (unsigned int threads : counts)
+	{
+		double lock_free = run<LockFree>(threads) / 1e6;
+		double locked = run<MutexABQ>(threads) / 1e6;
+
+		cout << threads << " | " << lock_free << " (" << lock_free / threads << ") | "
+			<< locked << " (" << locked / threads << ")\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "ABQ.h"
+#include "SPSCQ.h"
+using namespace std;
+
+// Benchmark: one producer thread hands timestamps to one consumer thread.
+// Throughput is items per second; latency is the time from enqueue to dequeue.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench_SPSCQ.cpp
+
+using Clock = chrono::steady_clock;
+
+const unsigned int CAPACITY = 1024;
+const unsigned int ITEMS = 10000000;
+
+static uint64_t now_ns()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// ABQ guarded by a mutex, bounded to CAPACITY so both queues apply the same back-pressure
+struct MutexABQ
+{
+	ABQ<uint64_t> queue;
+	mutex lock;
+
+	MutexABQ() : queue(CAPACITY) {}
+
+	bool try_enqueue(uint64_t data)
+	{
+		lock_guard<mutex> guard(lock);
+		if (queue.getSize() == CAPACITY)
+			return false;
+		queue.enqueue(data);
+		return true;
+	}
+
+	bool try_dequeue(uint64_t& data)
+	{
+		lock_guard<mutex> guard(lock);
+		if (queue.getSize() == 0)
+			return false;
+		data = queue.dequeue();
+		return true;
+	}
+};
+
+template <typename Queue>
+void run(const char* name, Queue& queue)
+{
+	vector<uint64_t> latencies;
+	latencies.reserve(ITEMS);
+
+	auto start = Clock::now();
+
+	thread producer([&queue]()
+	{
+		for (unsigned int i = 0; i < ITEMS; i++)
+		{
+			while (!queue.try_enqueue(now_ns()))
+				this_thread::yield();
+		}
+	});
+
+	thread consumer([&queue, &latencies]()
+	{
+		uint64_t stamp;
+		for (unsigned int i = 0; i < ITEMS; i++)
+		{
+			while (!queue.try_dequeue(stamp))
+				this_thread::yield();
+			latencies.push_back(now_ns() - stamp);
+		}
+	});
+
+	producer.join();
+	consumer.join();
+
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+	sort(latencies.begin(), latencies.end());
+
+	cout << name << ":\n";
+	cout << "  Throughput: " << ITEMS / seconds / 1e6 << " M ops/sec\n";
+	cout << "  Latency p50: " << latencies[ITEMS / 2] << " ns, p99: "
+		<< latencies[ITEMS / 100 * 99] << " ns, max: " << latencies.back() << " ns\n";
+}
+
+int main()
+{
+	cout << "Passing " << ITEMS << " items through a queue of capacity " << CAPACITY << "...\n\n";
+
+	MutexABQ locked;
+	run("Mutex-wrapped ABQ", locked);
+
+	SPSCQ<uint64_t> lock_free(CAPACITY);
+	run("SPSCQ", lock_free);
+
+	return 0;
+}
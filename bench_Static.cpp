@@ -0,0 +1,107 @@
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include "ABS.h"
+#include "ABQ.h"
+#include "StaticABS.h"
+#include "StaticABQ.h"
+using namespace std;
+
+// Benchmark: fill a container to CAPACITY and drain it again, ROUNDS times,
+// comparing the dynamic ABS/ABQ against the fixed-capacity StaticABS/StaticABQ.
+// The dynamic containers are pre-sized with reserve() so neither side resizes
+// and the difference is the capacity checks and the pointer indirection.
+//
+// Build: g++ -std=c++17 -O2 bench_Static.cpp
+
+using Clock = chrono::steady_clock;
+
+const unsigned int CAPACITY = 1024;
+const unsigned int ROUNDS = 100000;
+
+// Computed at compile time: sum of 1..CAPACITY pushed through each static container
+constexpr uint64_t static_stack_sum()
+{
+	StaticABS<uint64_t, CAPACITY> stack;
+	for (uint64_t i = 1; i <= CAPACITY; i++)
+		stack.push(i);
+
+	uint64_t sum = 0;
+	while (stack.getSize() > 0)
+		sum += stack.pop();
+	return sum;
+}
+
+constexpr uint64_t static_queue_sum()
+{
+	StaticABQ<uint64_t, CAPACITY> queue;
+	for (uint64_t i = 1; i <= CAPACITY; i++)
+		queue.enqueue(i);
+
+	uint64_t sum = 0;
+	while (queue.getSize() > 0)
+		sum += queue.dequeue();
+	return sum;
+}
+
+static_assert(static_stack_sum() == (uint64_t)CAPACITY * (CAPACITY + 1) / 2, "StaticABS is not constexpr-correct");
+static_assert(static_queue_sum() == (uint64_t)CAPACITY * (CAPACITY + 1) / 2, "StaticABQ is not constexpr-correct");
+
+// Returns nanoseconds per operation (a push or a pop counts as one)
+template <typename Stack>
+double run_stack(Stack& stack, uint64_t& checksum)
+{
+	auto start = Clock::now();
+	for (unsigned int round = 0; round < ROUNDS; round++)
+	{
+		for (uint64_t i = 0; i < CAPACITY; i++)
+			stack.push(i + round);
+		for (unsigned int i = 0; i < CAPACITY; i++)
+			checksum += stack.pop();
+	}
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+	return seconds * 1e9 / (2.0 * ROUNDS * CAPACITY);
+}
+
+// Half-fills the queue first so head and tail wrap around the ring every round
+template <typename Queue>
+double run_queue(Queue& queue, uint64_t& checksum)
+{
+	for (uint64_t i = 0; i < CAPACITY / 2; i++)
+		queue.enqueue(i);
+
+	auto start = Clock::now();
+	for (unsigned int round = 0; round < ROUNDS; round++)
+	{
+		for (uint64_t i = 0; i < CAPACITY / 2; i++)
+			queue.enqueue(i + round);
+		for (unsigned int i = 0; i < CAPACITY / 2; i++)
+			checksum += queue.dequeue();
+	}
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+	return seconds * 1e9 / (1.0 * ROUNDS * CAPACITY);
+}
+
+int main()
+{
+	uint64_t checksum = 0;
+
+	ABS<uint64_t> dynamic_stack;
+	dynamic_stack.reserve(CAPACITY);
+	StaticABS<uint64_t, CAPACITY>* static_stack = new StaticABS<uint64_t, CAPACITY>;
+
+	ABQ<uint64_t> dynamic_queue;
+	dynamic_queue.reserve(CAPACITY);
+	StaticABQ<uint64_t, CAPACITY>* static_queue = new StaticABQ<uint64_t, CAPACITY>;
+
+	cout << "Container | ns/op\n";
+	cout << "ABS | " << run_stack(dynamic_stack, checksum) << "\n";
+	cout << "StaticABS | " << run_stack(*static_stack, checksum) << "\n";
+	cout << "ABQ | " << run_queue(dynamic_queue, checksum) << "\n";
+	cout << "StaticABQ | " << run_queue(*static_queue, checksum) << "\n";
+	cout << "(checksum " << checksum << ")\n";
+
+	delete static_stack;
+	delete static_queue;
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include "WSD.h"
+using namespace std;
+
+// Fork-join benchmark: sum f(x) over a large array by recursively splitting the
+// range into halves. Each worker owns a WSD, works LIFO on its own deque and
+// steals FIFO from the others when it runs dry. Reports the speedup from 1 to
+// N worker threads.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench_WSD.cpp
+
+using Clock = chrono::steady_clock;
+
+const unsigned int ELEMENTS = 1 << 24;
+const unsigned int LEAF_SIZE = 1 << 12;
+
+struct Range
+{
+	unsigned int begin;
+	unsigned int end;
+};
+
+struct Pool
+{
+	vector<WSD<Range>*> deques;
+	const vector<double>* input;
+	atomic<long> pending;                   // Ranges pushed but not yet finished
+	atomic<double> total;
+};
+
+static void add(atomic<double>& total, double value)
+{
+	double current = total.load(memory_order_relaxed);
+	while (!total.compare_exchange_weak(current, current + value, memory_order_relaxed))
+		;
+}
+
+static void worker(Pool& pool, unsigned int id)
+{
+	WSD<Range>& own = *pool.deques[id];
+	unsigned int victim = id;
+	Range range;
+
+	while (pool.pending.load(memory_order_acquire) > 0)
+	{
+		if (!own.try_pop(range))
+		{
+			victim = (victim + 1) % pool.deques.size();
+			if (victim == id || !pool.deques[victim]->steal(range))
+				continue;
+		}
+
+		// Fork: split until the range is small, keeping one half and sharing the other
+		while (range.end - range.begin > LEAF_SIZE)
+		{
+			unsigned int middle = range.begin + (range.end - range.begin) / 2;
+			pool.pending.fetch_add(1, memory_order_relaxed);
+			own.push(Range{ middle, range.end });
+			range.end = middle;
+		}
+
+		double sum = 0;
+		for (unsigned int i = range.begin; i < range.end; i++)
+			sum += sqrt((*pool.input)[i]) * sin((*pool.input)[i]);
+		add(pool.total, sum);
+
+		// Join: the last finished range releases everyone
+		pool.pending.fetch_sub(1, memory_order_release);
+	}
+}
+
+static double run(unsigned int threads, const vector<double>& input, double& total)
+{
+	Pool pool;
+	pool.input = &input;
+	pool.total.store(0);
+	pool.pending.store(1);
+
+	for (unsigned int t = 0; t < threads; t++)
+		pool.deques.push_back(new WSD<Range>(64));
+	pool.deques[0]->push(Range{ 0, (unsigned int)input.size() });
+
+	auto start = Clock::now();
+	vector<thread> workers;
+	for (unsigned int t = 0; t < threads; t++)
+		workers.emplace_back(worker, ref(pool), t);
+	for (thread& w : workers)
+		w.join();
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+	for (WSD<Range>* deque : pool.deques)
+		delete deque;
+
+	total = pool.total.load();
+	return seconds;
+}
+
+int main()
+{
+	unsigned int cores = thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+
+	vector<double> input(ELEMENTS);
+	for (unsigned int i = 0; i < ELEMENTS; i++)
+		input[i] = i;
+
+	double baseline = 0, total;
+	cout << "Threads | Seconds | Speedup | Sum\n";
+
+	for (unsigned int threads = 1; threads <= cores; threads++)
+	{
+		double seconds = run(threads, input, total);
+		if (threads == 1)
+			baseline = seconds;
+
+		cout << threads << " | " << seconds << " | " << baseline / seconds << " | " << total << "\n";
+	}
+
+	return 0;
+}
@@ -27,10 +27,27 @@
  Modified by Joshua Fox 2020-6-3 to use stdout instead of stderr
  */
 
+/* included ahead of leaker.h, whose new/delete macros break these headers */
+#ifdef LEAKER_THREADSAFE
+#include <atomic>
+#include <mutex>
+#endif
+
+#ifdef LEAKER_BACKTRACE
+#include <execinfo.h>
+#endif
+
+#include <math.h>
+#include <time.h>
 #include "leaker.h"
+#include "leaker_log.h"
 
- /* global table containing allocation information */
-_HTABLE_T _leaker = { NULL, 0, 0, 0, 0, 0, 0, 0 };
+#if FRONT_GUARD % 16
+#error "FRONT_GUARD must be a multiple of 16 to keep blocks aligned"
+#endif
+
+ /* global tables containing allocation information */
+_HTABLE_T _leaker[LEAKER_SHARDS];
 
 
 /* disable macros for internal use */
@@ -40,79 +57,459 @@ _HTABLE_T _leaker = { NULL, 0, 0, 0, 0, 0, 0, 0 };
 #undef free
 
 #ifdef __cplusplus
-const char *_leaker_file = "unknown";
-const char *_leaker_func = "unknown";
-unsigned long _leaker_line = 0;
+LEAKER_TLS const char *_leaker_file = "unknown";
+LEAKER_TLS const char *_leaker_func = "unknown";
+LEAKER_TLS unsigned long _leaker_line = 0;
 
 #undef new
 #undef delete
 #endif
 
+/* frames of every captured stack that belong to Leaker itself:
+ * _Leaker_Backtrace(), _Leaker_Add() and the replacement allocator. Both
+ * functions are kept out of line so the count holds when optimizing */
+#define LEAKER_SKIP_FRAMES 3
+#ifdef __GNUC__
+#define LEAKER_NOINLINE __attribute__((noinline))
+#else
+#define LEAKER_NOINLINE
+#endif
+
+/* sequence number of the next insertion, shared by all shards */
+#ifdef LEAKER_THREADSAFE
+static std::atomic<size_t> _leaker_serial(0);
+static std::mutex _leaker_locks[LEAKER_SHARDS];
+#else
+static size_t _leaker_serial = 0;
+#endif
+
+/* sampling: mean bytes allocated between tracked allocations (0 tracks
+ * all), each thread's bytes left until its next sample, and its random state */
+static size_t _leaker_sample_rate = 0;
+static LEAKER_TLS size_t _leaker_sample_left = 0;
+static LEAKER_TLS unsigned long long _leaker_random = 0;
+
+/* whole-heap live bytes (without guards) and allocations, and their peak.
+ * Every new peak bumps _leaker_peak_epoch, which tells each site whether its
+ * peak_moment_ fields still need to be set for the latest peak. The
+ * snapshot interval is read by every allocation, so it is atomic too */
+#ifdef LEAKER_THREADSAFE
+static std::atomic<size_t> _leaker_live_bytes(0);
+static std::atomic<size_t> _leaker_live_count(0);
+static std::atomic<size_t> _leaker_peak_bytes(0);
+static std::atomic<size_t> _leaker_peak_epoch(0);
+static std::atomic<size_t> _leaker_snapshot_every(0);
+static std::mutex _leaker_heap_lock;
+#else
+static size_t _leaker_live_bytes = 0;
+static size_t _leaker_live_count = 0;
+static size_t _leaker_peak_bytes = 0;
+static size_t _leaker_peak_epoch = 0;
+static size_t _leaker_snapshot_every = 0;
+#endif
+static size_t _leaker_peak_count = 0;
+static size_t _leaker_peak_sequence = 0;
+
+/* snapshots of the heap totals, taken every _leaker_snapshot_every
+ * allocations (if not 0) and on demand */
+static _SNAPSHOT_T *_leaker_snapshots = NULL;
+static size_t _leaker_snapshot_count = 0;
+static size_t _leaker_snapshot_capacity = 0;
+
+/* deallocated blocks held back from reuse. _leaker_quarantine_on mirrors
+ * budget != 0, so frees of untracked blocks skip the lock while it is off */
+static _QUARANTINE_T _leaker_quarantine;
+#ifdef LEAKER_THREADSAFE
+static std::mutex _leaker_quarantine_lock;
+static std::atomic<int> _leaker_quarantine_on(0);
+#else
+static int _leaker_quarantine_on = 0;
+#endif
+
+/* event log: its file (NULL when off), records not yet written, the
+ * number of call sites written so far and the time it was opened */
+static FILE *_leaker_log = NULL;
+static _LEAKER_EVENT_T _leaker_log_buffer[LOG_BUFFER];
+static size_t _leaker_log_count = 0;
+static size_t _leaker_log_sites = 0;
+static unsigned long long _leaker_log_start = 0;
+#ifdef LEAKER_THREADSAFE
+static std::mutex _leaker_log_lock;
+#endif
+
 /* internal function prototypes */
-static void _Leaker_Init(void);
-static void _Leaker_Grow(void);
+static void _Leaker_Init(_HTABLE_T *shard);
+static void _Leaker_Grow(_HTABLE_T *shard);
+static void _Leaker_Migrate(_HTABLE_T *shard, size_t steps);
 
-static void _Leaker_Add(void *addr, size_t size, const char *alloc,
+LEAKER_NOINLINE static void _Leaker_Add(void *addr, size_t size, const char *alloc,
 	const char *file, const char *func, size_t line);
 static size_t _Leaker_Remove(void *addr, const char *dealloc, const char *file,
-	const char *func, size_t line);
-static _LEAK_T **_Leaker_Find(void *addr);
-
-static unsigned long _Leaker_Hash(void *addr);
+	const char *func, size_t line, _LEAK_T *removed);
+static _LEAK_T *_Leaker_Find(_HTABLE_T *shard, void *addr);
+static _LEAK_T *_Leaker_Probe(_LEAK_T *table, size_t rows, void *addr);
+static void _Leaker_Erase(_LEAK_T *table, size_t rows, _LEAK_T *slot);
+
+static unsigned long long _Leaker_Mix(unsigned long long key);
+static size_t _Leaker_Hash(void *addr, size_t rows);
+static _HTABLE_T *_Leaker_Shard(void *addr);
+static void _Leaker_Lock(_HTABLE_T *shard);
+static void _Leaker_Unlock(_HTABLE_T *shard);
+static void _Leaker_Lock_All(void);
+static void _Leaker_Unlock_All(void);
+static void _Leaker_Totals(_HTABLE_T *totals);
 
 static int _Leaker_Check_Dealloc(const char *alloc, const char *dealloc);
 static void _Leaker_Init_Guard(void *addr, size_t size);
 static int _Leaker_Check_Guard(void *addr, size_t size);
+static int _Leaker_Check_Front(void *addr);
+static int _Leaker_Check_Fill(const void *ptr, size_t size, unsigned char byte);
 static void _Leaker_Scribble(void *ptr, size_t size);
+static void _Leaker_Release(_LEAK_T *entry, const char *file,
+	const char *func, size_t line);
+static void _Leaker_Evict(size_t bytes);
+static int _Leaker_Check_Freed(_FREED_T *freed);
+static int _Leaker_Quarantined(void *addr, const char *dealloc,
+	const char *file, const char *func, size_t line);
+static void _Leaker_Free_Block(void *addr);
+static void _Leaker_Quarantine_Lock(void);
+static void _Leaker_Quarantine_Unlock(void);
 
-static void _Leaker_Print_Entry(_LEAK_T *entry);
+static int _Leaker_Print_Entry(_LEAK_T *entry);
 static void _Leaker_Report(void);
 
-static void _Leaker_Dump_Entry(_LEAK_T *entry);
-static _LEAK_T **_Leaker_Build_List(void);
+static int _Leaker_Dump_Entry(_LEAK_T *entry);
+static _LEAK_T **_Leaker_Build_List(size_t count,
+	int (*compare)(const void *, const void *));
 
 static int _Leaker_Compare_Entries(const void *first, const void *second);
+static int _Leaker_Compare_Addresses(const void *first, const void *second);
+
+static int _Leaker_Sampled(size_t size);
+static size_t _Leaker_Sample_Interval(void);
+static int _Leaker_Tracked(void *addr);
+static void *_Leaker_Untracked(void *ptr, const char *alloc);
+static void _Leaker_Estimate(_LEAK_T **table, size_t count);
+
+static size_t _Leaker_Site(_HTABLE_T *shard, const char *file,
+	const char *func, size_t line);
+static void _Leaker_Grow_Sites(_HTABLE_T *shard);
+static size_t *_Leaker_Probe_Site(_HTABLE_T *shard, const char *file,
+	const char *func, size_t line);
+static int _Leaker_Compare_Site_Keys(const void *first, const void *second);
+static int _Leaker_Compare_Site_Bytes(const void *first, const void *second);
+static void _Leaker_Free_Tables(void);
+
+LEAKER_NOINLINE static size_t _Leaker_Backtrace(void **frames);
+static size_t _Leaker_Trace(_HTABLE_T *shard, void **frames, size_t depth);
+static void _Leaker_Grow_Traces(_HTABLE_T *shard);
+static size_t *_Leaker_Probe_Trace(_HTABLE_T *shard, void **frames,
+	size_t depth, unsigned long hash);
+static unsigned long _Leaker_Hash_Trace(void **frames, size_t depth);
+static void _Leaker_Print_Trace(_HTABLE_T *shard, size_t trace);
+
+static void _Leaker_Log_Event(_HTABLE_T *shard, unsigned int type,
+	void *addr, size_t size, size_t site);
+static void _Leaker_Log_Write(unsigned int type, unsigned long long addr,
+	unsigned long long size, size_t site);
+static void _Leaker_Log_Flush(void);
+static void _Leaker_Log_End(void);
+static unsigned long long _Leaker_Now(void);
+
+static void _Leaker_Site_Peak(_SITE_T *site);
+static void _Leaker_Heap_Add(size_t bytes, size_t sequence);
+static void _Leaker_Heap_Remove(size_t bytes);
+static void _Leaker_Heap_Lock(void);
+static void _Leaker_Heap_Unlock(void);
+static void _Leaker_Take_Snapshot(size_t sequence);
+static int _Leaker_Compare_Site_Peak(const void *first, const void *second);
 
 /* dump current allocation information and statistics */
 void _Leaker_Dump(void)
 {
-	size_t overflows = _leaker.overflows;
+	_HTABLE_T totals;
+
+	_Leaker_Lock_All();
+	_Leaker_Totals(&totals);
 
 	fprintf(stdout, "\nLeaker report:\n");
 
-	if (_leaker.count == 0)
+	if (totals.count == 0)
 	{
 		fprintf(stdout, "No allocations.\n\n");
+		_Leaker_Unlock_All();
 		return;
 	}
 	else
 	{
-		_LEAK_T **table = _Leaker_Build_List();
+		_LEAK_T **table = _Leaker_Build_List(totals.count, _Leaker_Compare_Entries);
 		unsigned int i;
 		fprintf(stdout, "%lu allocations (%lu bytes) in table of %lu rows.\n",
-			_leaker.count, _leaker.bytes - _leaker.count * GUARD_SIZE,
-			_leaker.rows);
+			totals.count, totals.bytes - totals.count * GUARD_SIZE,
+			totals.rows);
+		_Leaker_Estimate(table, totals.count);
 
-		for (i = 0; i < _leaker.count; i++)
+		/* overflows found here are reported but not kept */
+		for (i = 0; i < totals.count; i++)
 		{
-			_Leaker_Dump_Entry(table[i]);
+			totals.overflows += _Leaker_Dump_Entry(table[i]);
 		}
 		fprintf(stdout, "\n");
 
 		free(table);
 	}
 
-	if (_leaker.mismatches)
+	if (totals.mismatches)
 		fprintf(stdout, "Mismatches: %lu allocation/deallocations don't match!\n",
-			_leaker.mismatches);
-	if (_leaker.overflows)
+			totals.mismatches);
+	if (totals.overflows)
 		fprintf(stdout, "Overflows: %lu allocations overflowed (wrote off end)!\n",
-			_leaker.overflows);
-	if (_leaker.bad_frees)
+			totals.overflows);
+	if (totals.bad_frees)
 		fprintf(stdout, "Bad deallocs: %lu attempts made to deallocate unallocated pointers!\n",
-			_leaker.bad_frees);
+			totals.bad_frees);
+
+	_Leaker_Unlock_All();
+}
+
+/* print the call-site profile. Work is proportional to the number of sites,
+ * not of allocations: the counters are kept up to date by every add and
+ * remove. With several shards the same site appears once per shard and is
+ * merged here; its peak is then the sum of the per-shard peaks, an upper
+ * bound on the true peak. */
+void _Leaker_Profile(void)
+{
+	_SITE_T *sites;
+	size_t count = 0, merged = 0, i;
+	size_t peak_bytes, peak_count, peak_sequence;
+	unsigned int s;
+
+	_Leaker_Lock_All();
+
+	for (s = 0; s < LEAKER_SHARDS; s++)
+		count += _leaker[s].site_count;
+
+	fprintf(stdout, "\nLeaker profile:\n");
+
+	if (count == 0)
+	{
+		fprintf(stdout, "No allocations.\n\n");
+		_Leaker_Unlock_All();
+		return;
+	}
+
+	if (!(sites = (_SITE_T *)malloc(sizeof(_SITE_T) * count)))
+	{
+		fprintf(stdout, "%s:%s():%i aborting: malloc failed!\n",
+			__FILE__, __func__, __LINE__);
+		exit(2);
+	}
+
+	for (s = 0, i = 0; s < LEAKER_SHARDS; s++)
+	{
+		memcpy(sites + i, _leaker[s].sites, sizeof(_SITE_T) * _leaker[s].site_count);
+		i += _leaker[s].site_count;
+	}
+
+	/* a site not changed since the latest peak held its live amounts then */
+	for (i = 0; i < count; i++)
+		_Leaker_Site_Peak(&sites[i]);
+
+	_Leaker_Heap_Lock();
+	peak_bytes = _leaker_peak_bytes;
+	peak_count = _leaker_peak_count;
+	peak_sequence = _leaker_peak_sequence;
+	_Leaker_Heap_Unlock();
+
+	_Leaker_Unlock_All();
+
+	/* merge the copies of each site from different shards */
+	qsort(sites, count, sizeof(_SITE_T), _Leaker_Compare_Site_Keys);
+	for (i = 0; i < count; i++)
+	{
+		if (merged && _Leaker_Compare_Site_Keys(&sites[merged - 1], &sites[i]) == 0)
+		{
+			sites[merged - 1].live_count += sites[i].live_count;
+			sites[merged - 1].live_bytes += sites[i].live_bytes;
+			sites[merged - 1].total_count += sites[i].total_count;
+			sites[merged - 1].peak_bytes += sites[i].peak_bytes;
+			sites[merged - 1].peak_moment_count += sites[i].peak_moment_count;
+			sites[merged - 1].peak_moment_bytes += sites[i].peak_moment_bytes;
+		}
+		else
+			sites[merged++] = sites[i];
+	}
+
+	qsort(sites, merged, sizeof(_SITE_T), _Leaker_Compare_Site_Bytes);
+
+	fprintf(stdout, "%lu call sites%s.\n", merged,
+		_leaker_sample_rate ? " (sampled allocations only)" : "");
+	fprintf(stdout, "%12s %10s %10s %12s  %s\n",
+		"live bytes", "live", "total", "peak bytes", "site");
+	for (i = 0; i < merged; i++)
+	{
+		fprintf(stdout, "%12lu %10lu %10lu %12lu  %s:%s():%lu\n",
+			sites[i].live_bytes, sites[i].live_count, sites[i].total_count,
+			sites[i].peak_bytes, sites[i].file, sites[i].func, sites[i].line);
+	}
+
+	/* the sites that held the most when the whole heap peaked */
+	fprintf(stdout, "\nHeap peak: %lu bytes in %lu allocations, after %lu allocations.\n",
+		peak_bytes, peak_count, peak_sequence);
+	qsort(sites, merged, sizeof(_SITE_T), _Leaker_Compare_Site_Peak);
+	fprintf(stdout, "%12s %10s  %s\n", "bytes", "live", "site");
+	for (i = 0; i < merged && i < 10 && sites[i].peak_moment_bytes; i++)
+	{
+		fprintf(stdout, "%12lu %10lu  %s:%s():%lu\n",
+			sites[i].peak_moment_bytes, sites[i].peak_moment_count,
+			sites[i].file, sites[i].func, sites[i].line);
+	}
+
+	_Leaker_Heap_Lock();
+	if (_leaker_snapshot_count)
+	{
+		fprintf(stdout, "\nSnapshots:\n");
+		fprintf(stdout, "%12s %12s %10s\n", "allocations", "live bytes", "live");
+		for (i = 0; i < _leaker_snapshot_count; i++)
+		{
+			fprintf(stdout, "%12lu %12lu %10lu\n", _leaker_snapshots[i].sequence,
+				_leaker_snapshots[i].bytes, _leaker_snapshots[i].count);
+		}
+	}
+	_Leaker_Heap_Unlock();
+	fprintf(stdout, "\n");
+
+	free(sites);
+}
+
+/* set the quarantine budget, releasing the oldest blocks that no longer fit */
+void _Leaker_Quarantine(size_t budget)
+{
+	_QUARANTINE_T *q = &_leaker_quarantine;
+
+	_Leaker_Quarantine_Lock();
+	q->budget = budget;
+	_leaker_quarantine_on = budget != 0;
+	_Leaker_Evict(0);
+
+	if (!q->count && q->ring)
+	{
+		free(q->ring);
+		q->ring = NULL;
+		q->capacity = 0;
+		q->head = 0;
+	}
+	_Leaker_Quarantine_Unlock();
+}
+
+/* check every live block's guards. Address order keeps the walk through
+ * memory sequential; damage found here is reported but not kept, it is
+ * counted again when the block is deallocated */
+size_t _Leaker_Verify(void)
+{
+	_HTABLE_T totals;
+	_LEAK_T **table;
+	size_t damaged = 0, i;
+
+	_Leaker_Lock_All();
+	_Leaker_Totals(&totals);
+
+	table = _Leaker_Build_List(totals.count, _Leaker_Compare_Addresses);
+	for (i = 0; i < totals.count; i++)
+	{
+		_LEAK_T *entry = table[i];
+		const char *where = NULL;
+
+		if (!_Leaker_Check_Front(entry->addr)) where = "before start";
+		else if (!_Leaker_Check_Guard(entry->addr, entry->size)) where = "off end";
+		if (!where) continue;
+
+		fprintf(stdout, "\nLEAKER: verify: checking error: wrote %s of memory allocated at %s:%s():%lu (address %p).\n\n",
+			where, entry->file, entry->func, entry->line, entry->addr);
+		_Leaker_Print_Trace(_Leaker_Shard(entry->addr), entry->trace);
+		damaged++;
+	}
+	if (table) free(table);
+
+	_Leaker_Unlock_All();
+
+	/* blocks in quarantine are checked again when released */
+	_Leaker_Quarantine_Lock();
+	for (i = 0; i < _leaker_quarantine.count; i++)
+	{
+		damaged += _Leaker_Check_Freed(&_leaker_quarantine.ring[
+			(_leaker_quarantine.head + i) % _leaker_quarantine.capacity]);
+	}
+	_Leaker_Quarantine_Unlock();
+
+	return damaged;
+}
+
+/* take a snapshot now, and every `every` allocations if every > 0 */
+void _Leaker_Snapshot(size_t every)
+{
+	_Leaker_Heap_Lock();
+	_leaker_snapshot_every = every;
+	_Leaker_Take_Snapshot(_leaker_serial);
+	_Leaker_Heap_Unlock();
+}
+
+/* switch sampling on (mean_bytes > 0) or off */
+void _Leaker_Sample(size_t mean_bytes)
+{
+	_leaker_sample_rate = mean_bytes;
+	_leaker_sample_left = 0;
+}
+
+/* start an event log at path, ending the current one first */
+void _Leaker_Log(const char *path)
+{
+	unsigned int s;
+	size_t i;
 
-	_leaker.overflows = overflows; /* restore current overflow count */
+	_Leaker_Lock_All();
+#ifdef LEAKER_THREADSAFE
+	_leaker_log_lock.lock();
+#endif
+
+	if (_leaker_log) _Leaker_Log_Flush();
+	if (_leaker_log)
+	{
+		fclose(_leaker_log);
+		_leaker_log = NULL;
+	}
+
+	if (path)
+	{
+		static int registered = 0;
+
+		if (!(_leaker_log = fopen(path, "wb")))
+			fprintf(stdout, "\nLEAKER: cannot open event log %s, not logging.\n\n", path);
+		else if (!registered)
+		{
+			atexit(_Leaker_Log_End);
+			registered = 1;
+		}
+	}
+
+	if (_leaker_log)
+	{
+		/* call sites are written again the first time they appear in a new log */
+		for (s = 0; s < LEAKER_SHARDS; s++)
+		{
+			for (i = 0; i < _leaker[s].site_count; i++)
+				_leaker[s].sites[i].log_id = 0;
+		}
+		_leaker_log_sites = 0;
+
+		_leaker_log_start = _Leaker_Now();
+		_Leaker_Log_Write(LEAKER_LOG_HEADER, LEAKER_LOG_MAGIC, _leaker_sample_rate, 0);
+	}
+
+#ifdef LEAKER_THREADSAFE
+	_leaker_log_lock.unlock();
+#endif
+	_Leaker_Unlock_All();
 }
 
 /* replacement for malloc */
@@ -120,6 +517,10 @@ void *_malloc(size_t size, const char *file, const char *func,
 	unsigned long line)
 {
 	void *ptr;
+
+	if (!_Leaker_Sampled(size))
+		return _Leaker_Untracked(malloc(size), "malloc");
+
 	size += GUARD_SIZE;
 
 	if (!(ptr = malloc(size)))
@@ -129,6 +530,7 @@ void *_malloc(size_t size, const char *file, const char *func,
 		exit(2);
 	}
 
+	ptr = (char *)ptr + FRONT_GUARD;
 	_Leaker_Init_Guard(ptr, size);
 	_Leaker_Add(ptr, size, "malloc", file, func, line);
 	return ptr;
@@ -139,6 +541,10 @@ void *_calloc(unsigned long count, size_t size, const char *file,
 	const char *func, unsigned long line)
 {
 	void *ptr;
+
+	if (!_Leaker_Sampled(size * count))
+		return _Leaker_Untracked(calloc(count, size), "calloc");
+
 	size = size * count + GUARD_SIZE;
 
 	if (!(ptr = calloc(1, size)))
@@ -148,6 +554,7 @@ void *_calloc(unsigned long count, size_t size, const char *file,
 		exit(2);
 	}
 
+	ptr = (char *)ptr + FRONT_GUARD;
 	_Leaker_Init_Guard(ptr, size);
 	_Leaker_Add(ptr, size, "calloc", file, func, line);
 	return ptr;
@@ -159,11 +566,27 @@ void *_realloc(void *ptr, size_t size, const char *file,
 {
 	void *ptr_new;
 	size_t old_size = 0, len;
+	_LEAK_T entry;
+
+	/* a block that was not sampled stays untracked. One still in quarantine
+	 * was deallocated already: it is reported and not copied, as when not
+	 * sampling */
+	if (_leaker_sample_rate)
+	{
+		if (ptr && !_Leaker_Tracked(ptr))
+		{
+			if (!_Leaker_Quarantined(ptr, "realloc", file, func, line))
+				return _Leaker_Untracked(realloc(ptr, size), "realloc");
+			ptr = NULL;
+		}
+		if (!ptr && !_Leaker_Sampled(size))
+			return _Leaker_Untracked(malloc(size), "realloc");
+	}
 
 	size += GUARD_SIZE;
 
 	/* check if pointer given to realloc is valid */
-	if (ptr && !(old_size = _Leaker_Remove(ptr, "realloc", file, func, line)))
+	if (ptr && !(old_size = _Leaker_Remove(ptr, "realloc", file, func, line, &entry)))
 	{
 		ptr = NULL;
 	}
@@ -175,6 +598,7 @@ void *_realloc(void *ptr, size_t size, const char *file,
 			__FILE__, __func__, __LINE__);
 		exit(2);
 	}
+	ptr_new = (char *)ptr_new + FRONT_GUARD;
 
 	/* if realloc was given a valid pointer, copy over the old data */
 	if (ptr)
@@ -184,8 +608,7 @@ void *_realloc(void *ptr, size_t size, const char *file,
 
 		memcpy(ptr_new, ptr, len);
 
-		_Leaker_Scribble(ptr, old_size);
-		free(ptr);
+		_Leaker_Release(&entry, file, func, line);
 	}
 
 	_Leaker_Init_Guard(ptr_new, size);
@@ -197,12 +620,12 @@ void *_realloc(void *ptr, size_t size, const char *file,
 void _free(void *ptr, const char *file, const char *func,
 	unsigned long line)
 {
-	size_t size;
-	if ((size = _Leaker_Remove(ptr, "free", file, func, line)))
-	{
-		_Leaker_Scribble(ptr, size);
+	_LEAK_T entry;
+	if (_Leaker_Remove(ptr, "free", file, func, line, &entry))
+		_Leaker_Release(&entry, file, func, line);
+	else if (_leaker_sample_rate /* not sampled, or deallocated already */
+		&& !_Leaker_Quarantined(ptr, "free", file, func, line))
 		free(ptr);
-	}
 }
 
 #ifdef __cplusplus
@@ -211,6 +634,15 @@ void _free(void *ptr, const char *file, const char *func,
 void* operator new (size_t size)
 {
 	void *ptr = NULL;
+
+	if (!_Leaker_Sampled(size))
+	{
+		_leaker_file = "unknown";
+		_leaker_func = "unknown";
+		_leaker_line = 0;
+		return _Leaker_Untracked(malloc(size), "new");
+	}
+
 	size += GUARD_SIZE;
 
 	if (!(ptr = malloc(size)))
@@ -220,6 +652,7 @@ void* operator new (size_t size)
 		exit(2);
 	}
 
+	ptr = (char *)ptr + FRONT_GUARD;
 	_Leaker_Init_Guard(ptr, size);
 	_Leaker_Add(ptr, size, "new", _leaker_file, _leaker_func, _leaker_line);
 
@@ -236,6 +669,15 @@ void* operator new (size_t size)
 void* operator new [](size_t size)
 {
 	void *ptr;
+
+	if (!_Leaker_Sampled(size))
+	{
+		_leaker_file = "unknown";
+		_leaker_func = "unknown";
+		_leaker_line = 0;
+		return _Leaker_Untracked(malloc(size), "new[]");
+	}
+
 	size += GUARD_SIZE;
 
 	if (!(ptr = malloc(size)))
@@ -245,6 +687,7 @@ void* operator new [](size_t size)
 		exit(2);
 	}
 
+	ptr = (char *)ptr + FRONT_GUARD;
 	_Leaker_Init_Guard(ptr, size);
 	_Leaker_Add(ptr, size, "new[]", _leaker_file, _leaker_func, _leaker_line);
 
@@ -260,13 +703,13 @@ void operator delete(void* ptr) throw ()
 {
 	if (ptr == nullptr)
 		return;
-	size_t size;
-	if ((size = _Leaker_Remove(ptr, "delete", _leaker_file, _leaker_func,
-		_leaker_line)))
-	{
-		_Leaker_Scribble(ptr, size);
+	_LEAK_T entry;
+	if (_Leaker_Remove(ptr, "delete", _leaker_file, _leaker_func,
+		_leaker_line, &entry))
+		_Leaker_Release(&entry, _leaker_file, _leaker_func, _leaker_line);
+	else if (_leaker_sample_rate /* not sampled, or deallocated already */
+		&& !_Leaker_Quarantined(ptr, "delete", _leaker_file, _leaker_func, _leaker_line))
 		free(ptr);
-	}
 }
 
 /* replacement for operator delete */
@@ -275,13 +718,13 @@ void operator delete(void* ptr, size_t sz) throw ()
 	if (ptr == nullptr)
 		return;
 	sz = sz;
-	size_t size;
-	if ((size = _Leaker_Remove(ptr, "delete", _leaker_file, _leaker_func,
-		_leaker_line)))
-	{
-		_Leaker_Scribble(ptr, size);
+	_LEAK_T entry;
+	if (_Leaker_Remove(ptr, "delete", _leaker_file, _leaker_func,
+		_leaker_line, &entry))
+		_Leaker_Release(&entry, _leaker_file, _leaker_func, _leaker_line);
+	else if (_leaker_sample_rate /* not sampled, or deallocated already */
+		&& !_Leaker_Quarantined(ptr, "delete", _leaker_file, _leaker_func, _leaker_line))
 		free(ptr);
-	}
 }
 
 /* replacement for operator vector delete */
@@ -289,13 +732,13 @@ void operator delete [](void* ptr) throw ()
 {
 	if (ptr == nullptr)
 		return;
-	size_t size;
-	if ((size = _Leaker_Remove(ptr, "delete[]", _leaker_file, _leaker_func,
-		_leaker_line)))
-	{
-		_Leaker_Scribble(ptr, size);
+	_LEAK_T entry;
+	if (_Leaker_Remove(ptr, "delete[]", _leaker_file, _leaker_func,
+		_leaker_line, &entry))
+		_Leaker_Release(&entry, _leaker_file, _leaker_func, _leaker_line);
+	else if (_leaker_sample_rate /* not sampled, or deallocated already */
+		&& !_Leaker_Quarantined(ptr, "delete[]", _leaker_file, _leaker_func, _leaker_line))
 		free(ptr);
-	}
 }
 
 /* replacement for operator vector delete */
@@ -304,186 +747,289 @@ void operator delete [](void* ptr, size_t sz) throw ()
 	if (ptr == nullptr)
 		return;
 	sz = sz;
-	size_t size;
-	if ((size = _Leaker_Remove(ptr, "delete[]", _leaker_file, _leaker_func,
-		_leaker_line)))
-	{
-		_Leaker_Scribble(ptr, size);
+	_LEAK_T entry;
+	if (_Leaker_Remove(ptr, "delete[]", _leaker_file, _leaker_func,
+		_leaker_line, &entry))
+		_Leaker_Release(&entry, _leaker_file, _leaker_func, _leaker_line);
+	else if (_leaker_sample_rate /* not sampled, or deallocated already */
+		&& !_Leaker_Quarantined(ptr, "delete[]", _leaker_file, _leaker_func, _leaker_line))
 		free(ptr);
-	}
 }
 
 #endif
 
 /* end of user-visible functions */
 
-/* initialize table */
-static void _Leaker_Init(void)
+/* initialize a shard */
+static void _Leaker_Init(_HTABLE_T *shard)
 {
-	_leaker.table = (_LEAK_T **)calloc(START_SIZE, sizeof(_LEAK_T *));
+	shard->table = (_LEAK_T *)calloc(START_SIZE, sizeof(_LEAK_T));
 
-	if (!_leaker.table)
+	if (!shard->table)
 	{
 		fprintf(stdout, "%s:%s():%i aborting: calloc() for table failed!\n",
 			__FILE__, __func__, __LINE__);
 		exit(2);
 	}
 
-	_leaker.rows = START_SIZE;
+	shard->rows = START_SIZE;
 
 	/* register so that leak information always displayed upon termination */
+#ifdef LEAKER_THREADSAFE
+	static std::once_flag registered;
+	std::call_once(registered, []() { atexit(_Leaker_Report); });
+#else
 	atexit(_Leaker_Report);
+#endif
 }
 
-/* grow table to accommodate more entries (by factor of 4) */
-static void _Leaker_Grow(void)
+/* grow table to accommodate more entries (by factor of 4). The entries are
+ * not moved here: the current table becomes old_table and _Leaker_Migrate()
+ * drains it a few rows at a time on later adds and removes */
+static void _Leaker_Grow(_HTABLE_T *shard)
 {
-	unsigned int i;
+	size_t i;
 
-	_HTABLE_T old = _leaker;
-	_leaker.rows *= 4;
-	_leaker.count = 0;
-	_leaker.bytes = 0;
+	/* a previous migration must be finished before the next one starts */
+	if (shard->old_table) _Leaker_Migrate(shard, (size_t)-1);
 
-	_leaker.table = (_LEAK_T **)calloc(_leaker.rows, sizeof(_LEAK_T *));
+	shard->old_table = shard->table;
+	shard->old_rows = shard->rows;
+	shard->rows *= 4;
 
-	if (!_leaker.table)
+	shard->table = (_LEAK_T *)calloc(shard->rows, sizeof(_LEAK_T));
+
+	if (!shard->table)
 	{
 		fprintf(stdout, "%s:%s():%i aborting: calloc() for table failed!\n",
 			__FILE__, __func__, __LINE__);
 		exit(2);
 	}
 
-	/* remove every entry from the old table and add it to the new */
-	for (i = 0; i < old.rows; i++)
+	/* start migrating at an empty row (one exists, the table is at most
+	 * half full), so every probe run is migrated as a whole */
+	for (i = 0; shard->old_table[i].addr; i++)
+		;
+	shard->cursor = i;
+	shard->unmigrated = shard->old_rows;
+}
+
+/* move at least the given number of old_table rows into the new table, then
+ * keep going to the end of the current probe run. Stopping only in front of
+ * an empty row keeps every run left in old_table intact, so lookups and
+ * removals there still work. Frees old_table once every row is visited. */
+static void _Leaker_Migrate(_HTABLE_T *shard, size_t steps)
+{
+	while (shard->old_table)
 	{
-		_LEAK_T *mover = old.table[i];
-		while (mover)
+		_LEAK_T *slot = &shard->old_table[shard->cursor];
+
+		if (!slot->addr && steps == 0) break;
+
+		if (slot->addr)
 		{
-			_LEAK_T *temp = mover;
-			mover = mover->next;
-			_leaker.serial = temp->sequence;
-			_Leaker_Add(temp->addr, temp->size, temp->alloc,
-				temp->file, temp->func, temp->line);
-			free(temp);
+			*_Leaker_Probe(shard->table, shard->rows, slot->addr) = *slot;
+			slot->addr = NULL;
 		}
-	}
-	_leaker.serial = old.serial;
 
-	free(old.table);
+		if (++shard->cursor == shard->old_rows) shard->cursor = 0;
+		if (steps) steps--;
+
+		if (--shard->unmigrated == 0)
+		{
+			free(shard->old_table);
+			shard->old_table = NULL;
+			shard->old_rows = 0;
+		}
+	}
 }
 
-/* add a new allocation to the table */
+/* add a new allocation to its shard */
 void _Leaker_Add(void *addr, size_t size, const char *alloc,
 	const char *file, const char *func, size_t line)
 {
-	_LEAK_T **mover, *temp;
+	_HTABLE_T *shard = _Leaker_Shard(addr);
+	_LEAK_T *slot;
+	_SITE_T *site;
+	void *frames[LEAKER_TRACE_DEPTH + LEAKER_SKIP_FRAMES];
+	size_t depth = _Leaker_Backtrace(frames); /* outside the lock, it is slow */
 
-	if (!_leaker.table) _Leaker_Init();
-	if (_leaker.count > _leaker.rows / 2) _Leaker_Grow();
+	_Leaker_Lock(shard);
 
-	mover = &(_leaker.table[_Leaker_Hash(addr)]);
-	while (*mover)
-	{
-		if ((*mover)->addr == addr) break;
+	if (!shard->table) _Leaker_Init(shard);
+	_Leaker_Migrate(shard, MIGRATE_STEP);
+	if (shard->count > shard->rows / 2) _Leaker_Grow(shard);
 
-		mover = &((*mover)->next);
-	}
+	slot = _Leaker_Find(shard, addr);
 
-	if (*mover) /* if an address is allocated twice, we are in trouble! */
+	if (slot->addr) /* if an address is allocated twice, we are in trouble! */
 	{
 		fprintf(stdout, "%s:%s():%lu fatal error: address %p already in use!\n",
 			file, func, line, addr);
 		exit(2);
 	}
 
-	if (!(temp = (_LEAK_T *)malloc(sizeof(_LEAK_T))))
-	{
-		fprintf(stdout, "%s:%s():%i aborting: malloc() for entry failed!\n",
-			__FILE__, __func__, __LINE__);
-		exit(2);
-	}
-
-	temp->addr = addr;
-	temp->size = size;
-	temp->sequence = _leaker.serial++;
-	temp->alloc = alloc;
-	temp->file = file;
-	temp->func = func;
-	temp->line = line;
-	temp->next = NULL;
-
-	*mover = temp;
-
-	_leaker.count++;
-	_leaker.bytes += size;
+	slot->addr = addr;
+	slot->size = size;
+	slot->sequence = _leaker_serial++;
+	slot->alloc = alloc;
+	slot->file = file;
+	slot->func = func;
+	slot->line = line;
+	slot->site = _Leaker_Site(shard, file, func, line);
+	slot->trace = depth ? _Leaker_Trace(shard, frames + LEAKER_SKIP_FRAMES, depth) : 0;
+
+	shard->count++;
+	shard->bytes += size;
+
+	site = &shard->sites[slot->site];
+	_Leaker_Site_Peak(site);
+	site->live_count++;
+	site->live_bytes += size - GUARD_SIZE;
+	site->total_count++;
+	if (site->live_bytes > site->peak_bytes) site->peak_bytes = site->live_bytes;
+	_Leaker_Heap_Add(size - GUARD_SIZE, slot->sequence);
+
+	if (_leaker_log)
+		_Leaker_Log_Event(shard, strcmp(alloc, "realloc") == 0 ? LEAKER_LOG_REALLOC
+			: LEAKER_LOG_ALLOC, addr, size - GUARD_SIZE, slot->site);
+
+	_Leaker_Unlock(shard);
 }
 
-/* remove an allocation from the table, and report any inconsistencies */
+/* remove an allocation from its shard, and report any inconsistencies */
 size_t _Leaker_Remove(void *addr, const char *dealloc, const char *file,
-	const char *func, size_t line)
+	const char *func, size_t line, _LEAK_T *removed)
 {
-	_LEAK_T **mover, *temp;
-	size_t size;
+	_HTABLE_T *shard = _Leaker_Shard(addr);
+	_LEAK_T *slot, entry;
+
+	_Leaker_Lock(shard);
 
-	if (!_leaker.table) _Leaker_Init();
+	if (!shard->table) _Leaker_Init(shard);
+	_Leaker_Migrate(shard, MIGRATE_STEP);
 
-	mover = _Leaker_Find(addr);
+	slot = _Leaker_Find(shard, addr);
 
-	if (!*mover) /* given a bad pointer */
+	if (!slot->addr) /* given a bad pointer, or one that was not sampled */
 	{
-		fprintf(stdout, "\nLEAKER: %s:%s():%lu %s error: pointer was not allocated!\n\n",
-			file, func, line, dealloc);
-		_leaker.bad_frees++;
+		if (!_leaker_sample_rate)
+		{
+			fprintf(stdout, "\nLEAKER: %s:%s():%lu %s error: pointer was not allocated!\n\n",
+				file, func, line, dealloc);
+			shard->bad_frees++;
+		}
+		_Leaker_Unlock(shard);
 		return 0;
 	}
 
-	temp = *mover;
-	*mover = temp->next;
-	_leaker.count--;
-	_leaker.bytes -= temp->size;
-
-	size = temp->size;
-
-	if (!_Leaker_Check_Guard(addr, temp->size)) /* guard overwritten */
+	entry = *removed = *slot;
+	if (shard->old_table && slot >= shard->old_table
+		&& slot < shard->old_table + shard->old_rows)
+		_Leaker_Erase(shard->old_table, shard->old_rows, slot);
+	else
+		_Leaker_Erase(shard->table, shard->rows, slot);
+	shard->count--;
+	shard->bytes -= entry.size;
+	_Leaker_Site_Peak(&shard->sites[entry.site]);
+	shard->sites[entry.site].live_count--;
+	shard->sites[entry.site].live_bytes -= entry.size - GUARD_SIZE;
+	_Leaker_Heap_Remove(entry.size - GUARD_SIZE);
+
+	if (_leaker_log)
+		_Leaker_Log_Event(shard, LEAKER_LOG_FREE, addr, entry.size - GUARD_SIZE,
+			entry.site);
+
+	if (!_Leaker_Check_Front(addr)) /* front guard overwritten */
+	{
+		fprintf(stdout, "\nLEAKER: %s:%s():%lu checking error: wrote before start of memory allocated at %s:%s():%lu.\n\n",
+			file, func, line, entry.file, entry.func, entry.line);
+		_Leaker_Print_Trace(shard, entry.trace);
+		shard->overflows++;
+	}
+	else if (!_Leaker_Check_Guard(addr, entry.size)) /* guard overwritten */
 	{
 		fprintf(stdout, "\nLEAKER: %s:%s():%lu checking error: wrote off end of memory allocated at %s:%s():%lu.\n\n",
-			file, func, line, temp->file, temp->func, temp->line);
-		_leaker.overflows++;
+			file, func, line, entry.file, entry.func, entry.line);
+		_Leaker_Print_Trace(shard, entry.trace);
+		shard->overflows++;
 	}
-	if (!_Leaker_Check_Dealloc(temp->alloc, dealloc)) /* wrong dealloc function */
+	if (!_Leaker_Check_Dealloc(entry.alloc, dealloc)) /* wrong dealloc function */
 	{
 		fprintf(stdout, "\nLEAKER: %s:%s():%lu mismatch error: memory allocated at %s:%s():%lu with %s, deallocated with %s.\n\n",
-			file, func, line, temp->file, temp->func, temp->line,
-			temp->alloc, dealloc);
-		_leaker.mismatches++;
+			file, func, line, entry.file, entry.func, entry.line,
+			entry.alloc, dealloc);
+		_Leaker_Print_Trace(shard, entry.trace);
+		shard->mismatches++;
+	}
+
+	_Leaker_Unlock(shard);
+	return entry.size;
+}
+
+/* find a pointer in a shard's table (or in its old_table while migrating),
+ * return its slot, or the empty slot in the table where it would be inserted */
+static _LEAK_T *_Leaker_Find(_HTABLE_T *shard, void *addr)
+{
+	_LEAK_T *slot = _Leaker_Probe(shard->table, shard->rows, addr);
+
+	if (!slot->addr && shard->old_table)
+	{
+		_LEAK_T *old = _Leaker_Probe(shard->old_table, shard->old_rows, addr);
+		if (old->addr) return old;
 	}
+	return slot;
+}
 
-	free(temp);
-	return size;
+/* linear probing from the hash of a pointer: return its slot in the given
+ * table, or the first empty slot of its probe run */
+static _LEAK_T *_Leaker_Probe(_LEAK_T *table, size_t rows, void *addr)
+{
+	size_t i = _Leaker_Hash(addr, rows);
+	while (table[i].addr && table[i].addr != addr)
+	{
+		if (++i == rows) i = 0;
+	}
+	return &table[i];
 }
 
-/* find a pointer in the table, return a pointer to a pointer to it */
-static _LEAK_T **_Leaker_Find(void *addr)
+/* empty a slot without leaving a tombstone: later entries of the same probe
+ * run are shifted back into the hole, so _Leaker_Probe() never has to skip
+ * deleted slots */
+static void _Leaker_Erase(_LEAK_T *table, size_t rows, _LEAK_T *slot)
 {
-	_LEAK_T **mover = &(_leaker.table[_Leaker_Hash(addr)]);
-	while (*mover)
+	size_t hole = slot - table, i = hole;
+
+	for (;;)
 	{
-		if ((*mover)->addr == addr) break;
+		size_t home;
+
+		if (++i == rows) i = 0;
+		if (!table[i].addr) break;
 
-		mover = &((*mover)->next);
+		/* the entry at i may fill the hole unless its home slot lies
+		 * cyclically in (hole, i], i.e. the hole is before its probe start */
+		home = _Leaker_Hash(table[i].addr, rows);
+		if (hole <= i ? (home <= hole || home > i) : (home <= hole && home > i))
+		{
+			table[hole] = table[i];
+			hole = i;
+		}
 	}
-	return mover;
+
+	table[hole].addr = NULL;
 }
 
 /* Thomas Wang's 64-bit hash function - works well for integers, and is
  * significantly faster than the DJB function since.  It is also slightly
  * better in distributing keys.
  * http://www.concentric.net/~Ttwang/tech/inthash.htm
+ * Works on unsigned long long, since unsigned long is only 32 bits on
+ * Windows and 32-bit targets.
  */
-static unsigned long _Leaker_Hash(void *addr)
+static unsigned long long _Leaker_Mix(unsigned long long key)
 {
-	unsigned long address = (unsigned long)addr;
+	unsigned long long address = key;
 	address = (~address) + (address << 21); /* (a << 21) - a - 1; */
 	address = address ^ (address >> 24);
 	address = (address + (address << 3)) + (address << 8); /* a * 265 */
@@ -491,7 +1037,71 @@ static unsigned long _Leaker_Hash(void *addr)
 	address = (address + (address << 2)) + (address << 4); /* a * 21 */
 	address = address ^ (address >> 28);
 	address = address + (address << 31);
-	return address % _leaker.rows;
+	return address;
+}
+
+/* row of a pointer in a table of the given size */
+static size_t _Leaker_Hash(void *addr, size_t rows)
+{
+	return (size_t)(_Leaker_Mix((size_t)addr) % rows);
+}
+
+/* shard that tracks a pointer. Uses the high bits of the hash, since the
+ * low bits pick the row inside the shard */
+static _HTABLE_T *_Leaker_Shard(void *addr)
+{
+	return &_leaker[(_Leaker_Mix((size_t)addr) >> 32) % LEAKER_SHARDS];
+}
+
+/* take and release the lock of one shard (no-ops unless LEAKER_THREADSAFE) */
+static void _Leaker_Lock(_HTABLE_T *shard)
+{
+#ifdef LEAKER_THREADSAFE
+	_leaker_locks[shard - _leaker].lock();
+#else
+	(void)shard;
+#endif
+}
+
+static void _Leaker_Unlock(_HTABLE_T *shard)
+{
+#ifdef LEAKER_THREADSAFE
+	_leaker_locks[shard - _leaker].unlock();
+#else
+	(void)shard;
+#endif
+}
+
+/* take every shard lock, always in the same order, for a consistent report */
+static void _Leaker_Lock_All(void)
+{
+	unsigned int i;
+	for (i = 0; i < LEAKER_SHARDS; i++)
+		_Leaker_Lock(&_leaker[i]);
+}
+
+static void _Leaker_Unlock_All(void)
+{
+	unsigned int i;
+	for (i = LEAKER_SHARDS; i > 0; i--)
+		_Leaker_Unlock(&_leaker[i - 1]);
+}
+
+/* sum the counters of every shard; table fields of totals are left NULL */
+static void _Leaker_Totals(_HTABLE_T *totals)
+{
+	unsigned int i;
+
+	memset(totals, 0, sizeof(_HTABLE_T));
+	for (i = 0; i < LEAKER_SHARDS; i++)
+	{
+		totals->rows += _leaker[i].rows;
+		totals->count += _leaker[i].count;
+		totals->bytes += _leaker[i].bytes;
+		totals->overflows += _leaker[i].overflows;
+		totals->mismatches += _leaker[i].mismatches;
+		totals->bad_frees += _leaker[i].bad_frees;
+	}
 }
 
 /* return 1 if the allocator and deallocator are compatible, 0 otherwise */
@@ -512,98 +1122,312 @@ static int _Leaker_Check_Dealloc(const char *alloc, const char *dealloc)
 	return 0;
 }
 
-/* initialize the guard at the end of the allocation */
+/* initialize the guards around the allocation; size includes them */
 static void _Leaker_Init_Guard(void *addr, size_t size)
 {
-	strncpy((char *)addr + size - GUARD_SIZE, GUARD_STR, GUARD_SIZE);
+#if FRONT_GUARD
+	memset((char *)addr - FRONT_GUARD, GUARD_BYTE, FRONT_GUARD);
+#endif
+	memset((char *)addr + size - GUARD_SIZE, GUARD_BYTE, BACK_GUARD);
 }
 
 /* verify the guard at the end of the allocation, return 1 if successful */
 static int _Leaker_Check_Guard(void *addr, size_t size)
 {
-	return (strncmp((char *)addr + size - GUARD_SIZE, GUARD_STR, GUARD_SIZE)
-		== 0);
+	return _Leaker_Check_Fill((char *)addr + size - GUARD_SIZE, BACK_GUARD,
+		GUARD_BYTE);
+}
+
+/* verify the guard in front of the allocation, return 1 if successful */
+static int _Leaker_Check_Front(void *addr)
+{
+	return _Leaker_Check_Fill((char *)addr - FRONT_GUARD, FRONT_GUARD,
+		GUARD_BYTE);
+}
+
+/* return 1 if size bytes at ptr all equal byte. Compares a word at a time,
+ * with memcpy for the loads since guards need not be aligned */
+static int _Leaker_Check_Fill(const void *ptr, size_t size, unsigned char byte)
+{
+	const unsigned char *p = (const unsigned char *)ptr;
+	size_t pattern = ((size_t)-1 / 0xFF) * byte, word;
+
+	for (; size >= sizeof(size_t); p += sizeof(size_t), size -= sizeof(size_t))
+	{
+		memcpy(&word, p, sizeof(size_t));
+		if (word != pattern) return 0;
+	}
+	for (; size; p++, size--)
+	{
+		if (*p != byte) return 0;
+	}
+	return 1;
 }
 
 /* zap a give allocation - mainly useful to make later mistakes easier to see */
 static void _Leaker_Scribble(void *ptr, size_t size)
 {
-	memset(ptr, '\0', size);
+	memset(ptr, SCRIBBLE_BYTE, size);
 }
 
-/* report leaks and errors, and deallocate all remaining memory */
-static void _Leaker_Report(void)
+/* scribble over a deallocated block, guards included, and free it, or put
+ * it in quarantine to be freed later */
+static void _Leaker_Release(_LEAK_T *entry, const char *file,
+	const char *func, size_t line)
 {
-	if (!(_leaker.count || _leaker.mismatches || _leaker.overflows
-		|| _leaker.bad_frees))
+	_QUARANTINE_T *q = &_leaker_quarantine;
+	_FREED_T *freed;
+
+	_Leaker_Scribble((char *)entry->addr - FRONT_GUARD, entry->size);
+
+	_Leaker_Quarantine_Lock();
+
+	if (entry->size > q->budget) /* off, or too big to hold */
 	{
-		if (_leaker.table) free(_leaker.table);
+		_Leaker_Quarantine_Unlock();
+		_Leaker_Free_Block(entry->addr);
 		return;
 	}
 
-	fprintf(stdout, "\nLEAKER: errors found!\n");
+	_Leaker_Evict(entry->size);
 
-	if (_leaker.count) /* print out list of leaks, clean up */
+	/* grow the ring, unwrapping it, when full */
+	if (q->count == q->capacity)
 	{
-		unsigned int i;
-		_LEAK_T **table = _Leaker_Build_List();
-
-		fprintf(stdout, "Leaks found: %lu allocations (%lu bytes).\n",
-			_leaker.count, _leaker.bytes - _leaker.count * GUARD_SIZE);
+		size_t capacity = q->capacity ? q->capacity * 2 : START_SIZE, i;
+		_FREED_T *ring = (_FREED_T *)malloc(sizeof(_FREED_T) * capacity);
 
-		for (i = 0; i < _leaker.count; i++)
+		if (!ring)
 		{
-			_Leaker_Print_Entry(table[i]);
-			free(table[i]->addr);
-			free(table[i]);
+			fprintf(stdout, "%s:%s():%i aborting: malloc() for quarantine failed!\n",
+				__FILE__, __func__, __LINE__);
+			exit(2);
 		}
-
-		fprintf(stdout, "\n");
-		free(table);
+		for (i = 0; i < q->count; i++)
+			ring[i] = q->ring[(q->head + i) % q->capacity];
+		free(q->ring);
+		q->ring = ring;
+		q->capacity = capacity;
+		q->head = 0;
 	}
 
-	if (_leaker.table) free(_leaker.table);
+	freed = &q->ring[(q->head + q->count) % q->capacity];
+	freed->addr = entry->addr;
+	freed->size = entry->size;
+	freed->file = entry->file;
+	freed->func = entry->func;
+	freed->line = entry->line;
+	freed->free_file = file;
+	freed->free_func = func;
+	freed->free_line = line;
+	freed->trace = entry->trace;
+
+	q->count++;
+	q->bytes += entry->size;
+
+	_Leaker_Quarantine_Unlock();
+}
 
-	/* report other errors */
-	if (_leaker.mismatches)
-		fprintf(stdout, "Mismatches: %lu allocation/deallocations don't match.\n",
-			_leaker.mismatches);
+/* release the oldest blocks in quarantine until bytes more fit in the
+ * budget, checking that each still holds the scribble pattern. Caller holds
+ * the quarantine lock */
+static void _Leaker_Evict(size_t bytes)
+{
+	_QUARANTINE_T *q = &_leaker_quarantine;
 
-	if (_leaker.overflows)
-		fprintf(stdout, "Overflows: %lu allocations overflowed (wrote off end).\n",
-			_leaker.overflows);
-	if (_leaker.bad_frees)
-		fprintf(stdout, "Bad deallocs: %lu attempts made to deallocate unallocated pointers.\n",
-			_leaker.bad_frees);
+	while (q->count && q->bytes + bytes > q->budget)
+	{
+		_FREED_T *freed = &q->ring[q->head];
 
+		q->damaged += _Leaker_Check_Freed(freed);
+		_Leaker_Free_Block(freed->addr);
+
+		if (++q->head == q->capacity) q->head = 0;
+		q->count--;
+		q->bytes -= freed->size;
+	}
 }
 
-/* print the given entry */
-static void _Leaker_Print_Entry(_LEAK_T *entry)
+/* report a quarantined block that was written after deallocation, return 1
+ * if it was */
+static int _Leaker_Check_Freed(_FREED_T *freed)
 {
-	fprintf(stdout, "%s:%s():%lu memory leak: memory was not deallocated.\n",
-		entry->file, entry->func, entry->line);
-	if (!_Leaker_Check_Guard(entry->addr, entry->size))
-	{
+	_HTABLE_T *shard;
+
+	if (_Leaker_Check_Fill((char *)freed->addr - FRONT_GUARD, freed->size,
+		SCRIBBLE_BYTE))
+		return 0;
+
+	fprintf(stdout, "\nLEAKER: %s:%s():%lu use after free: memory allocated at %s:%s():%lu was written after deallocation (address %p).\n\n",
+		freed->free_file, freed->free_func, freed->free_line,
+		freed->file, freed->func, freed->line, freed->addr);
+
+	shard = _Leaker_Shard(freed->addr);
+	_Leaker_Lock(shard);
+	_Leaker_Print_Trace(shard, freed->trace);
+	_Leaker_Unlock(shard);
+	return 1;
+}
+
+/* a pointer that is not in the table may be a block held in quarantine,
+ * deallocated once already. Report the double free and return 1 if it is;
+ * the block is left to be released by the quarantine */
+static int _Leaker_Quarantined(void *addr, const char *dealloc,
+	const char *file, const char *func, size_t line)
+{
+	_QUARANTINE_T *q = &_leaker_quarantine;
+	_FREED_T *freed;
+	_HTABLE_T *shard;
+	size_t i;
+
+	if (!_leaker_quarantine_on)
+		return 0;
+
+	_Leaker_Quarantine_Lock();
+	for (i = 0; i < q->count; i++)
+	{
+		freed = &q->ring[(q->head + i) % q->capacity];
+		if (freed->addr != addr)
+			continue;
+
+		fprintf(stdout, "\nLEAKER: %s:%s():%lu %s error: memory allocated at %s:%s():%lu was already deallocated at %s:%s():%lu!\n\n",
+			file, func, line, dealloc, freed->file, freed->func, freed->line,
+			freed->free_file, freed->free_func, freed->free_line);
+
+		shard = _Leaker_Shard(addr);
+		_Leaker_Lock(shard);
+		_Leaker_Print_Trace(shard, freed->trace);
+		_Leaker_Unlock(shard);
+
+		q->double_frees++;
+		_Leaker_Quarantine_Unlock();
+		return 1;
+	}
+	_Leaker_Quarantine_Unlock();
+	return 0;
+}
+
+/* hand a tracked block back to the system */
+static void _Leaker_Free_Block(void *addr)
+{
+	free((char *)addr - FRONT_GUARD);
+}
+
+/* take and release the quarantine lock (no-ops unless LEAKER_THREADSAFE) */
+static void _Leaker_Quarantine_Lock(void)
+{
+#ifdef LEAKER_THREADSAFE
+	_leaker_quarantine_lock.lock();
+#endif
+}
+
+static void _Leaker_Quarantine_Unlock(void)
+{
+#ifdef LEAKER_THREADSAFE
+	_leaker_quarantine_lock.unlock();
+#endif
+}
+
+/* report leaks and errors, and deallocate all remaining memory */
+static void _Leaker_Report(void)
+{
+	_HTABLE_T totals;
+	unsigned int i;
+
+	/* release, and so check, every block still in quarantine */
+	_Leaker_Quarantine(0);
+
+	/* finish the event log while the call sites it refers to still exist */
+	_Leaker_Log(NULL);
+
+	_Leaker_Lock_All();
+	_Leaker_Totals(&totals);
+
+	if (!(totals.count || totals.mismatches || totals.overflows
+		|| totals.bad_frees || _leaker_quarantine.damaged
+		|| _leaker_quarantine.double_frees))
+	{
+		_Leaker_Free_Tables();
+		_Leaker_Unlock_All();
+		return;
+	}
+
+	fprintf(stdout, "\nLEAKER: errors found!\n");
+
+	if (totals.count) /* print out list of leaks, clean up */
+	{
+		_LEAK_T **table = _Leaker_Build_List(totals.count, _Leaker_Compare_Entries);
+
+		fprintf(stdout, "Leaks found: %lu allocations (%lu bytes).\n",
+			totals.count, totals.bytes - totals.count * GUARD_SIZE);
+		_Leaker_Estimate(table, totals.count);
+
+		for (i = 0; i < totals.count; i++)
+		{
+			totals.overflows += _Leaker_Print_Entry(table[i]);
+			_Leaker_Free_Block(table[i]->addr);
+		}
+
+		fprintf(stdout, "\n");
+		free(table);
+	}
+
+	_Leaker_Free_Tables();
+
+	/* report other errors */
+	if (totals.mismatches)
+		fprintf(stdout, "Mismatches: %lu allocation/deallocations don't match.\n",
+			totals.mismatches);
+
+	if (totals.overflows)
+		fprintf(stdout, "Overflows: %lu allocations overflowed (wrote off end).\n",
+			totals.overflows);
+	if (totals.bad_frees)
+		fprintf(stdout, "Bad deallocs: %lu attempts made to deallocate unallocated pointers.\n",
+			totals.bad_frees);
+	if (_leaker_quarantine.damaged)
+		fprintf(stdout, "Use after free: %lu deallocated blocks were written to.\n",
+			_leaker_quarantine.damaged);
+	if (_leaker_quarantine.double_frees)
+		fprintf(stdout, "Double frees: %lu deallocated blocks were deallocated again.\n",
+			_leaker_quarantine.double_frees);
+
+	_Leaker_Unlock_All();
+}
+
+/* print the given entry, return 1 if it overflowed */
+static int _Leaker_Print_Entry(_LEAK_T *entry)
+{
+	fprintf(stdout, "%s:%s():%lu memory leak: memory was not deallocated.\n",
+		entry->file, entry->func, entry->line);
+	_Leaker_Print_Trace(_Leaker_Shard(entry->addr), entry->trace);
+	if (!_Leaker_Check_Front(entry->addr))
+	{
+		fprintf(stdout, "%s:%s():%lu checking error: wrote before start of allocation.\n",
+			entry->file, entry->func, entry->line);
+		return 1;
+	}
+	if (!_Leaker_Check_Guard(entry->addr, entry->size))
+	{
 		fprintf(stdout, "%s:%s():%lu checking error: wrote off end of allocation.\n",
 			entry->file, entry->func, entry->line);
-		_leaker.overflows++;
+		return 1;
 	}
+	return 0;
 }
 
-/* dump the given entry */
-static void _Leaker_Dump_Entry(_LEAK_T *entry)
+/* dump the given entry, return 1 if it overflowed */
+static int _Leaker_Dump_Entry(_LEAK_T *entry)
 {
 	fprintf(stdout, "%s:%s():%lu address: %p bytes: %lu",
 		entry->file, entry->func, entry->line, entry->addr,
 		entry->size - GUARD_SIZE);
-	if (!_Leaker_Check_Guard(entry->addr, entry->size))
-	{
-		fprintf(stdout, " OVERFLOWED.\n");
-		_leaker.overflows++;
-	}
-	else
-		fprintf(stdout, ".\n");
+	int overflowed = !_Leaker_Check_Front(entry->addr)
+		|| !_Leaker_Check_Guard(entry->addr, entry->size);
+
+	fprintf(stdout, overflowed ? " OVERFLOWED.\n" : ".\n");
+	_Leaker_Print_Trace(_Leaker_Shard(entry->addr), entry->trace);
+	return overflowed;
 }
 
 /* compare two leak entries based upon their sequence number */
@@ -614,15 +1438,26 @@ static int _Leaker_Compare_Entries(const void *first, const void *second)
 	return (int)(f->sequence - s->sequence);
 }
 
-/* build and return a sorted list of leak entry pointers */
-static _LEAK_T **_Leaker_Build_List(void)
+/* compare two leak entries based upon their address */
+static int _Leaker_Compare_Addresses(const void *first, const void *second)
+{
+	const _LEAK_T *f = *(_LEAK_T **)first, *s = *(_LEAK_T **)second;
+
+	if (f->addr != s->addr) return f->addr < s->addr ? -1 : 1;
+	return 0;
+}
+
+/* build and return a list of the count live entries of every shard, sorted
+ * with compare. Caller holds every shard lock. */
+static _LEAK_T **_Leaker_Build_List(size_t count,
+	int (*compare)(const void *, const void *))
 {
 	_LEAK_T **table, **mover;
-	unsigned int i;
+	unsigned int i, s;
 
-	if (!_leaker.table || !_leaker.count) return NULL;
+	if (!count) return NULL;
 
-	if (!(table = (_LEAK_T **)malloc(sizeof(_LEAK_T *) * _leaker.count)))
+	if (!(table = (_LEAK_T **)malloc(sizeof(_LEAK_T *) * count)))
 	{
 		fprintf(stdout, "%s:%s():%i aborting: malloc failed!\n",
 			__FILE__, __func__, __LINE__);
@@ -631,19 +1466,557 @@ static _LEAK_T **_Leaker_Build_List(void)
 
 	mover = table;
 
-	for (i = 0; i < _leaker.rows; i++)
+	for (s = 0; s < LEAKER_SHARDS; s++)
 	{
-		_LEAK_T *temp = _leaker.table[i];
+		_HTABLE_T *shard = &_leaker[s];
 
-		while (temp)
+		for (i = 0; i < shard->rows; i++)
 		{
-			*mover = temp;
-			mover++;
-			temp = temp->next;
+			if (shard->table[i].addr)
+			{
+				*mover = &shard->table[i];
+				mover++;
+			}
+		}
+
+		/* entries not yet migrated out of the old table */
+		for (i = 0; i < shard->old_rows; i++)
+		{
+			if (shard->old_table[i].addr)
+			{
+				*mover = &shard->old_table[i];
+				mover++;
+			}
 		}
 	}
 
-	qsort((void *)table, _leaker.count, sizeof(_LEAK_T *), _Leaker_Compare_Entries);
+	qsort((void *)table, count, sizeof(_LEAK_T *), compare);
 
 	return table;
-}
\ No newline at end of file
+}
+
+/* decide whether an allocation of size bytes is tracked. Each thread counts
+ * down the bytes it allocates, and the allocation that crosses zero is
+ * sampled, so the chance of sampling grows with the size of the allocation */
+static int _Leaker_Sampled(size_t size)
+{
+	if (!_leaker_sample_rate) return 1;
+
+	if (!_leaker_sample_left) _leaker_sample_left = _Leaker_Sample_Interval();
+
+	if (size < _leaker_sample_left)
+	{
+		_leaker_sample_left -= size;
+		return 0;
+	}
+
+	_leaker_sample_left = _Leaker_Sample_Interval();
+	return 1;
+}
+
+/* bytes until the next sample: exponentially distributed with a mean of
+ * _leaker_sample_rate, which makes sampling a Poisson process over bytes */
+static size_t _Leaker_Sample_Interval(void)
+{
+	unsigned long long x;
+	double uniform;
+
+	/* xorshift64*, seeded from the address of each thread's own state */
+	if (!_leaker_random)
+		_leaker_random = (unsigned long long)(size_t)&_leaker_random ^ 0x9E3779B97F4A7C15ULL;
+	x = _leaker_random;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	_leaker_random = x;
+
+	uniform = (double)(((x * 2685821657736338717ULL) >> 11) + 1) / 9007199254740992.0; /* (0, 1] */
+	return (size_t)(-log(uniform) * (double)_leaker_sample_rate) + 1;
+}
+
+/* return 1 if the pointer is in the table */
+static int _Leaker_Tracked(void *addr)
+{
+	_HTABLE_T *shard = _Leaker_Shard(addr);
+	int tracked = 0;
+
+	_Leaker_Lock(shard);
+	if (shard->table) tracked = _Leaker_Find(shard, addr)->addr != NULL;
+	_Leaker_Unlock(shard);
+
+	return tracked;
+}
+
+/* hand back an allocation that is not sampled: no guard, no table entry */
+static void *_Leaker_Untracked(void *ptr, const char *alloc)
+{
+	if (!ptr)
+	{
+		fprintf(stdout, "%s:%s():%i aborting: %s() failed!\n",
+			__FILE__, __func__, __LINE__, alloc);
+		exit(2);
+	}
+	return ptr;
+}
+
+/* when sampling, print what the sampled entries stand for. An allocation of
+ * s bytes is sampled with probability p = 1 - exp(-s / rate), so it counts
+ * as 1 / p allocations and s / p bytes */
+static void _Leaker_Estimate(_LEAK_T **table, size_t count)
+{
+	double allocs = 0, bytes = 0;
+	size_t i;
+
+	if (!_leaker_sample_rate) return;
+
+	for (i = 0; i < count; i++)
+	{
+		double size = (double)(table[i]->size - GUARD_SIZE);
+		double p = 1 - exp(-size / (double)_leaker_sample_rate);
+
+		if (p <= 0) p = 1;
+		allocs += 1 / p;
+		bytes += size / p;
+	}
+
+	fprintf(stdout, "Sampling 1 in %lu bytes: estimated %.0f allocations (%.0f bytes) in total.\n",
+		_leaker_sample_rate, allocs, bytes);
+}
+
+/* return the index of a call site in a shard's site list, adding it if new */
+static size_t _Leaker_Site(_HTABLE_T *shard, const char *file,
+	const char *func, size_t line)
+{
+	size_t *row;
+	_SITE_T *site;
+
+	if (shard->site_count >= shard->site_rows / 2) _Leaker_Grow_Sites(shard);
+
+	row = _Leaker_Probe_Site(shard, file, func, line);
+	if (*row) return *row - 1;
+
+	if (shard->site_count == shard->site_capacity)
+	{
+		size_t capacity = shard->site_capacity ? shard->site_capacity * 2 : START_SIZE;
+		_SITE_T *sites = (_SITE_T *)realloc(shard->sites, sizeof(_SITE_T) * capacity);
+
+		if (!sites)
+		{
+			fprintf(stdout, "%s:%s():%i aborting: realloc() for sites failed!\n",
+				__FILE__, __func__, __LINE__);
+			exit(2);
+		}
+		shard->sites = sites;
+		shard->site_capacity = capacity;
+	}
+
+	site = &shard->sites[shard->site_count];
+	memset(site, 0, sizeof(_SITE_T));
+	site->file = file;
+	site->func = func;
+	site->line = line;
+
+	*row = ++shard->site_count;
+	return shard->site_count - 1;
+}
+
+/* grow the site index by a factor of 4 and re-index every site. Sites are
+ * few compared to allocations, so this is done all at once */
+static void _Leaker_Grow_Sites(_HTABLE_T *shard)
+{
+	size_t i;
+
+	free(shard->site_index);
+	shard->site_rows = shard->site_rows ? shard->site_rows * 4 : START_SIZE;
+
+	if (!(shard->site_index = (size_t *)calloc(shard->site_rows, sizeof(size_t))))
+	{
+		fprintf(stdout, "%s:%s():%i aborting: calloc() for sites failed!\n",
+			__FILE__, __func__, __LINE__);
+		exit(2);
+	}
+
+	for (i = 0; i < shard->site_count; i++)
+	{
+		_SITE_T *site = &shard->sites[i];
+		*_Leaker_Probe_Site(shard, site->file, site->func, site->line) = i + 1;
+	}
+}
+
+/* linear probing for a call site: return its row in the site index, or the
+ * empty row where it would go */
+static size_t *_Leaker_Probe_Site(_HTABLE_T *shard, const char *file,
+	const char *func, size_t line)
+{
+	size_t i = _Leaker_Hash((void *)((size_t)file ^ ((size_t)func << 1) ^ (line << 4)),
+		shard->site_rows);
+
+	while (shard->site_index[i])
+	{
+		_SITE_T *site = &shard->sites[shard->site_index[i] - 1];
+		if (site->file == file && site->func == func && site->line == line) break;
+
+		if (++i == shard->site_rows) i = 0;
+	}
+	return &shard->site_index[i];
+}
+
+/* order sites by call site, to bring copies from different shards together */
+static int _Leaker_Compare_Site_Keys(const void *first, const void *second)
+{
+	const _SITE_T *f = (const _SITE_T *)first, *s = (const _SITE_T *)second;
+
+	if (f->file != s->file) return f->file < s->file ? -1 : 1;
+	if (f->func != s->func) return f->func < s->func ? -1 : 1;
+	if (f->line != s->line) return f->line < s->line ? -1 : 1;
+	return 0;
+}
+
+/* order sites by live bytes, then by allocations ever made, largest first */
+static int _Leaker_Compare_Site_Bytes(const void *first, const void *second)
+{
+	const _SITE_T *f = (const _SITE_T *)first, *s = (const _SITE_T *)second;
+
+	if (f->live_bytes != s->live_bytes) return f->live_bytes > s->live_bytes ? -1 : 1;
+	if (f->total_count != s->total_count) return f->total_count > s->total_count ? -1 : 1;
+	return 0;
+}
+
+/* release the tables of every shard at exit */
+static void _Leaker_Free_Tables(void)
+{
+	unsigned int i;
+	size_t j;
+
+	for (i = 0; i < LEAKER_SHARDS; i++)
+	{
+		if (_leaker[i].table) free(_leaker[i].table);
+		if (_leaker[i].old_table) free(_leaker[i].old_table);
+		if (_leaker[i].sites) free(_leaker[i].sites);
+		if (_leaker[i].site_index) free(_leaker[i].site_index);
+
+		for (j = 0; j < _leaker[i].trace_count; j++)
+		{
+			if (_leaker[i].traces[j].symbols) free(_leaker[i].traces[j].symbols);
+		}
+		if (_leaker[i].traces) free(_leaker[i].traces);
+		if (_leaker[i].trace_index) free(_leaker[i].trace_index);
+
+		/* back to the state before the first allocation */
+		memset(&_leaker[i], 0, sizeof(_HTABLE_T));
+	}
+
+	if (_leaker_snapshots) free(_leaker_snapshots);
+	_leaker_snapshots = NULL;
+	_leaker_snapshot_count = 0;
+	_leaker_snapshot_capacity = 0;
+}
+
+
+/* capture the current call stack into frames, which has room for
+ * LEAKER_TRACE_DEPTH + LEAKER_SKIP_FRAMES entries. Return the number of
+ * frames left once Leaker's own are skipped, 0 without LEAKER_BACKTRACE */
+static size_t _Leaker_Backtrace(void **frames)
+{
+#ifdef LEAKER_BACKTRACE
+	int depth = backtrace(frames, LEAKER_TRACE_DEPTH + LEAKER_SKIP_FRAMES);
+
+	return depth > LEAKER_SKIP_FRAMES ? (size_t)depth - LEAKER_SKIP_FRAMES : 0;
+#else
+	(void)frames;
+	return 0;
+#endif
+}
+
+/* return the index + 1 of a stack in a shard's trace list, adding it if new */
+static size_t _Leaker_Trace(_HTABLE_T *shard, void **frames, size_t depth)
+{
+	unsigned long hash = _Leaker_Hash_Trace(frames, depth);
+	size_t *row;
+	_TRACE_T *trace;
+
+	if (shard->trace_count >= shard->trace_rows / 2) _Leaker_Grow_Traces(shard);
+
+	row = _Leaker_Probe_Trace(shard, frames, depth, hash);
+	if (*row) return *row;
+
+	if (shard->trace_count == shard->trace_capacity)
+	{
+		size_t capacity = shard->trace_capacity ? shard->trace_capacity * 2 : START_SIZE;
+		_TRACE_T *traces = (_TRACE_T *)realloc(shard->traces, sizeof(_TRACE_T) * capacity);
+
+		if (!traces)
+		{
+			fprintf(stdout, "%s:%s():%i aborting: realloc() for traces failed!\n",
+				__FILE__, __func__, __LINE__);
+			exit(2);
+		}
+		shard->traces = traces;
+		shard->trace_capacity = capacity;
+	}
+
+	trace = &shard->traces[shard->trace_count];
+	memcpy(trace->frames, frames, sizeof(void *) * depth);
+	trace->depth = depth;
+	trace->hash = hash;
+	trace->symbols = NULL;
+
+	*row = ++shard->trace_count;
+	return shard->trace_count;
+}
+
+/* grow the trace index by a factor of 4 and re-index every trace */
+static void _Leaker_Grow_Traces(_HTABLE_T *shard)
+{
+	size_t i;
+
+	free(shard->trace_index);
+	shard->trace_rows = shard->trace_rows ? shard->trace_rows * 4 : START_SIZE;
+
+	if (!(shard->trace_index = (size_t *)calloc(shard->trace_rows, sizeof(size_t))))
+	{
+		fprintf(stdout, "%s:%s():%i aborting: calloc() for traces failed!\n",
+			__FILE__, __func__, __LINE__);
+		exit(2);
+	}
+
+	for (i = 0; i < shard->trace_count; i++)
+	{
+		_TRACE_T *trace = &shard->traces[i];
+		*_Leaker_Probe_Trace(shard, trace->frames, trace->depth, trace->hash) = i + 1;
+	}
+}
+
+/* linear probing for a stack: return its row in the trace index, or the
+ * empty row where it would go */
+static size_t *_Leaker_Probe_Trace(_HTABLE_T *shard, void **frames,
+	size_t depth, unsigned long hash)
+{
+	size_t i = hash % shard->trace_rows;
+
+	while (shard->trace_index[i])
+	{
+		_TRACE_T *trace = &shard->traces[shard->trace_index[i] - 1];
+		if (trace->hash == hash && trace->depth == depth
+			&& memcmp(trace->frames, frames, sizeof(void *) * depth) == 0) break;
+
+		if (++i == shard->trace_rows) i = 0;
+	}
+	return &shard->trace_index[i];
+}
+
+/* combine the hashes of every frame of a stack */
+static unsigned long _Leaker_Hash_Trace(void **frames, size_t depth)
+{
+	unsigned long hash = depth;
+	size_t i;
+
+	for (i = 0; i < depth; i++)
+		hash = (unsigned long)_Leaker_Mix(hash ^ (size_t)frames[i]);
+	return hash;
+}
+
+/* print the stack with the given index + 1, one frame per line. Names are
+ * looked up the first time a stack is printed and kept for later reports */
+static void _Leaker_Print_Trace(_HTABLE_T *shard, size_t trace)
+{
+#ifdef LEAKER_BACKTRACE
+	_TRACE_T *t;
+	size_t i;
+
+	if (!trace) return;
+	t = &shard->traces[trace - 1];
+
+	if (!t->symbols) t->symbols = backtrace_symbols(t->frames, (int)t->depth);
+
+	for (i = 0; i < t->depth; i++)
+	{
+		if (t->symbols) fprintf(stdout, "    at %s\n", t->symbols[i]);
+		else fprintf(stdout, "    at %p\n", t->frames[i]);
+	}
+#else
+	(void)shard;
+	(void)trace;
+#endif
+}
+
+/* write one allocation or deallocation to the event log, preceded by its
+ * call site the first time the site appears. Caller holds the shard lock */
+static void _Leaker_Log_Event(_HTABLE_T *shard, unsigned int type,
+	void *addr, size_t size, size_t site)
+{
+	_SITE_T *s = &shard->sites[site];
+
+#ifdef LEAKER_THREADSAFE
+	std::lock_guard<std::mutex> guard(_leaker_log_lock);
+#endif
+	if (!_leaker_log) return;
+
+	if (!s->log_id)
+	{
+		size_t file_len = strlen(s->file) + 1, func_len = strlen(s->func) + 1;
+
+		s->log_id = ++_leaker_log_sites;
+		_Leaker_Log_Write(LEAKER_LOG_SITE, file_len + func_len, s->line, s->log_id - 1);
+
+		/* the names go straight after the site record */
+		_Leaker_Log_Flush();
+		if (!_leaker_log) return;
+		fwrite(s->file, 1, file_len, _leaker_log);
+		fwrite(s->func, 1, func_len, _leaker_log);
+	}
+
+	_Leaker_Log_Write(type, (unsigned long long)(size_t)addr, size, s->log_id - 1);
+}
+
+/* append a record to the log buffer, writing the buffer out when full.
+ * Caller holds the log lock */
+static void _Leaker_Log_Write(unsigned int type, unsigned long long addr,
+	unsigned long long size, size_t site)
+{
+	_LEAKER_EVENT_T *event = &_leaker_log_buffer[_leaker_log_count];
+
+	event->time = _Leaker_Now() - _leaker_log_start;
+	event->addr = addr;
+	event->size = size;
+	event->site = (unsigned int)site;
+	event->type = type;
+
+	if (++_leaker_log_count == LOG_BUFFER) _Leaker_Log_Flush();
+}
+
+/* write out the buffered records, and stop logging if that fails. Caller
+ * holds the log lock */
+static void _Leaker_Log_Flush(void)
+{
+	if (_leaker_log_count
+		&& fwrite(_leaker_log_buffer, sizeof(_LEAKER_EVENT_T), _leaker_log_count,
+			_leaker_log) != _leaker_log_count)
+	{
+		fprintf(stdout, "\nLEAKER: writing the event log failed, not logging.\n\n");
+		fclose(_leaker_log);
+		_leaker_log = NULL;
+	}
+	_leaker_log_count = 0;
+}
+
+/* close the event log at exit */
+static void _Leaker_Log_End(void)
+{
+	_Leaker_Log(NULL);
+}
+
+/* current time in nanoseconds, from a clock that never goes backwards */
+static unsigned long long _Leaker_Now(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* before a site's live amounts change, keep what they were at the latest
+ * heap peak if that has not been done yet. With several threads, sites of
+ * other shards may change around the moment of a peak, so the amounts at
+ * the peak are approximate there */
+static void _Leaker_Site_Peak(_SITE_T *site)
+{
+	size_t epoch = _leaker_peak_epoch;
+
+	if (site->peak_epoch != epoch)
+	{
+		site->peak_epoch = epoch;
+		site->peak_moment_count = site->live_count;
+		site->peak_moment_bytes = site->live_bytes;
+	}
+}
+
+/* count an allocation in the heap totals, record a new peak, and take a
+ * periodic snapshot when one is due */
+static void _Leaker_Heap_Add(size_t bytes, size_t sequence)
+{
+	size_t live = (_leaker_live_bytes += bytes);
+	size_t every = _leaker_snapshot_every;
+
+	_leaker_live_count++;
+
+	if (live > _leaker_peak_bytes)
+	{
+		_Leaker_Heap_Lock();
+		if (live > _leaker_peak_bytes)
+		{
+			_leaker_peak_bytes = live;
+			_leaker_peak_count = _leaker_live_count;
+			_leaker_peak_sequence = sequence + 1;
+			_leaker_peak_epoch++;
+		}
+		_Leaker_Heap_Unlock();
+	}
+
+	if (every && (sequence + 1) % every == 0)
+	{
+		_Leaker_Heap_Lock();
+		_Leaker_Take_Snapshot(sequence + 1);
+		_Leaker_Heap_Unlock();
+	}
+}
+
+/* count a deallocation in the heap totals */
+static void _Leaker_Heap_Remove(size_t bytes)
+{
+	_leaker_live_bytes -= bytes;
+	_leaker_live_count--;
+}
+
+/* take and release the lock of the heap peak and snapshots */
+static void _Leaker_Heap_Lock(void)
+{
+#ifdef LEAKER_THREADSAFE
+	_leaker_heap_lock.lock();
+#endif
+}
+
+static void _Leaker_Heap_Unlock(void)
+{
+#ifdef LEAKER_THREADSAFE
+	_leaker_heap_lock.unlock();
+#endif
+}
+
+/* append the current heap totals to the snapshots. Caller holds the heap
+ * lock */
+static void _Leaker_Take_Snapshot(size_t sequence)
+{
+	_SNAPSHOT_T *snapshot;
+
+	if (_leaker_snapshot_count == _leaker_snapshot_capacity)
+	{
+		size_t capacity = _leaker_snapshot_capacity ? _leaker_snapshot_capacity * 2 : START_SIZE;
+		_SNAPSHOT_T *snapshots = (_SNAPSHOT_T *)realloc(_leaker_snapshots,
+			sizeof(_SNAPSHOT_T) * capacity);
+
+		if (!snapshots)
+		{
+			fprintf(stdout, "%s:%s():%i aborting: realloc() for snapshots failed!\n",
+				__FILE__, __func__, __LINE__);
+			exit(2);
+		}
+		_leaker_snapshots = snapshots;
+		_leaker_snapshot_capacity = capacity;
+	}
+
+	snapshot = &_leaker_snapshots[_leaker_snapshot_count++];
+	snapshot->sequence = sequence;
+	snapshot->bytes = _leaker_live_bytes;
+	snapshot->count = _leaker_live_count;
+}
+
+/* order sites by the bytes they held at the heap peak, largest first */
+static int _Leaker_Compare_Site_Peak(const void *first, const void *second)
+{
+	const _SITE_T *f = (const _SITE_T *)first, *s = (const _SITE_T *)second;
+
+	if (f->peak_moment_bytes != s->peak_moment_bytes)
+		return f->peak_moment_bytes > s->peak_moment_bytes ? -1 : 1;
+	return _Leaker_Compare_Site_Bytes(first, second);
+}
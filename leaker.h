@@ -33,40 +33,174 @@ Modified by Joshua Fox 2019-5-30 to ignore delete called on nullptr
 #endif
 
 #define START_SIZE  128     /* Initial size of memory allocation table */
+#define MIGRATE_STEP 8      /* Old table slots moved per add/remove while growing */
+#define LOG_BUFFER  2048    /* Event log records buffered between writes */
+
+/* Define LEAKER_THREADSAFE to track allocations from several threads. The
+ * table is then split into LEAKER_SHARDS independently locked shards, picked
+ * by the hash of the address, and the call site set by the new/delete macros
+ * is kept per thread. Requires C++11. */
+#ifdef LEAKER_THREADSAFE
+#define LEAKER_SHARDS 16    /* Number of independently locked tables */
+#define LEAKER_TLS  thread_local
+#else
+#define LEAKER_SHARDS 1
+#define LEAKER_TLS
+#endif
 
-#define GUARD_SIZE  4       /* Padding at the end of each allocated block */
-#define GUARD_STR   "\014\033\014"  /* magic string to pad allocation */
+/* Define LEAKER_BACKTRACE to also record the call stack of every tracked
+ * allocation, up to LEAKER_TRACE_DEPTH frames, with backtrace() from glibc
+ * or macOS. Identical stacks are stored once per shard, and turned into
+ * symbol names only when a report prints them (link with -rdynamic to get
+ * function names rather than bare addresses). */
+#ifndef LEAKER_TRACE_DEPTH
+#define LEAKER_TRACE_DEPTH 16
+#endif
+
+/* Guards around each allocated block, filled with GUARD_BYTE and checked a
+ * word at a time: FRONT_GUARD bytes before the block, which must be a
+ * multiple of 16 to keep the block aligned, and BACK_GUARD bytes after it.
+ * Either can be set on the command line, e.g. -DFRONT_GUARD=16 */
+#ifndef FRONT_GUARD
+#define FRONT_GUARD 0
+#endif
+#ifndef BACK_GUARD
+#define BACK_GUARD  8
+#endif
+#define GUARD_SIZE  (FRONT_GUARD + BACK_GUARD) /* Padding added to each block */
+#define GUARD_BYTE  0x1B    /* fills the guards */
+#define SCRIBBLE_BYTE 0xDD  /* fills deallocated blocks */
 
 typedef struct _LEAK_T
 {
-    void *addr;             /* address of memory allocated              */
+    void *addr;             /* address allocated, NULL for an empty slot */
     const char *alloc;      /* type of allocator used                   */
     size_t size;            /* size of allocated memory (bytes)         */
     size_t sequence;		/* relative position of allocation in code  */
     const char *file;       /* name of file where allocation made       */
     const char *func;       /* name of function where allocation made   */
     size_t line;			/* line number where allocation made        */
-    struct _LEAK_T *next;   /* linked list pointer                      */
+    size_t site;			/* index of the call site in its shard      */
+    size_t trace;			/* index + 1 of the stack in its shard, or 0 */
 } _LEAK_T;
 
 typedef struct
 {
-    _LEAK_T **table;
+    const char *file;       /* name of file where allocations made      */
+    const char *func;       /* name of function where allocations made  */
+    size_t line;			/* line number where allocations made       */
+    size_t live_count;		/* allocations not yet deallocated          */
+    size_t live_bytes;		/* bytes not yet deallocated                */
+    size_t total_count;		/* allocations ever made                    */
+    size_t peak_bytes;		/* largest live_bytes reached               */
+    size_t log_id;			/* id + 1 in the event log, 0 if not written */
+    size_t peak_epoch;		/* heap peak at which the two below were set */
+    size_t peak_moment_count;	/* live_count at that heap peak          */
+    size_t peak_moment_bytes;	/* live_bytes at that heap peak          */
+} _SITE_T;
+
+typedef struct
+{
+    void *addr;             /* address that was allocated               */
+    size_t size;            /* size of the block, guards included       */
+    const char *file;       /* where the block was allocated            */
+    const char *func;
+    size_t line;
+    const char *free_file;  /* where the block was deallocated          */
+    const char *free_func;
+    size_t free_line;
+    size_t trace;           /* stack of the allocation, as in _LEAK_T   */
+} _FREED_T;
+
+typedef struct
+{
+    _FREED_T *ring;         /* deallocated blocks, oldest at head       */
+    size_t capacity;        /* allocated length of ring                 */
+    size_t head;            /* index of the oldest block                */
+    size_t count;           /* number of blocks held                    */
+    size_t bytes;           /* bytes held, guards included              */
+    size_t budget;          /* most bytes to hold, 0 when off           */
+    size_t damaged;         /* blocks found written after deallocation  */
+    size_t double_frees;    /* blocks deallocated again while held      */
+} _QUARANTINE_T;
+
+typedef struct
+{
+    size_t sequence;		/* allocations made when it was taken       */
+    size_t bytes;			/* live bytes, without guards               */
+    size_t count;			/* live allocations                         */
+} _SNAPSHOT_T;
+
+typedef struct
+{
+    void *frames[LEAKER_TRACE_DEPTH]; /* return addresses, innermost first */
+    size_t depth;			/* number of frames recorded                */
+    unsigned long hash;		/* hash of the frames                       */
+    char **symbols;			/* frame names, made when first printed     */
+} _TRACE_T;
+
+typedef struct
+{
+    _LEAK_T *table;			/* open-addressed slots, linear probing   */
     size_t rows;			/* number of rows in table                */
+    _LEAK_T *old_table;		/* table being migrated, NULL if none     */
+    size_t old_rows;		/* number of rows in old_table            */
+    size_t cursor;			/* next old_table row to migrate          */
+    size_t unmigrated;		/* old_table rows not yet visited         */
     size_t count;			/* number of entries in table             */
     size_t bytes;			/* number of bytes currently allocated    */
-    size_t serial;			/* number of next insertion               */
     
     size_t overflows;		/* number of incorrect deallocations      */
     size_t mismatches;		/* number of mismatched allocs/deallocs   */
     size_t bad_frees;		/* number of bad attempts to free         */
+
+    _SITE_T *sites;			/* call sites, in order of first use      */
+    size_t site_count;		/* number of sites                        */
+    size_t site_capacity;	/* allocated length of sites              */
+    size_t *site_index;		/* open-addressed site number + 1, 0 free */
+    size_t site_rows;		/* number of rows in site_index           */
+
+    _TRACE_T *traces;		/* distinct stacks, in order of first use */
+    size_t trace_count;		/* number of traces                       */
+    size_t trace_capacity;	/* allocated length of traces             */
+    size_t *trace_index;	/* open-addressed trace number + 1, 0 free */
+    size_t trace_rows;		/* number of rows in trace_index          */
 } _HTABLE_T;
 
-extern _HTABLE_T _leaker;
+extern _HTABLE_T _leaker[LEAKER_SHARDS];
 
 /* report information on current memory allocations */
 void _Leaker_Dump(void);
 
+/* report live and total allocations grouped by call site, largest first,
+ * then the heap peak with the sites that held the most at that moment, and
+ * the snapshots taken so far */
+void _Leaker_Profile(void);
+
+/* hold on to up to budget bytes of deallocated blocks, oldest released
+ * first, and check when releasing them that they were not written after
+ * deallocation. Deallocating a held block again is reported as a double
+ * free (0, the default, releases blocks at once) */
+void _Leaker_Quarantine(size_t budget);
+
+/* check the guards of every live block, walking them in address order, and
+ * the blocks held in quarantine; report the blocks written out of bounds
+ * or after deallocation, and return how many there are */
+size_t _Leaker_Verify(void);
+
+/* take a snapshot of live bytes and allocations now and, if every > 0, after
+ * every `every` allocations from now on. _Leaker_Profile() prints them */
+void _Leaker_Snapshot(size_t every);
+
+/* track only a sample of allocations, on average one per mean_bytes bytes
+ * allocated (0, the default, tracks all). Set it once, before allocating */
+void _Leaker_Sample(size_t mean_bytes);
+
+/* write every tracked allocation and deallocation to a binary event log at
+ * path, for leaker_replay to analyze later (see leaker_log.h), or stop
+ * logging if path is NULL. Set it once, before allocating from threads */
+void _Leaker_Log(const char *path);
+
 /* replacement for standard C allocation and deallocation functions */
 void *_malloc(size_t size, const char *file, const char *func,
                      unsigned long line);
@@ -86,9 +220,9 @@ void _free(void *ptr, const char *file, const char *func,
 #ifdef __cplusplus
 
 /* hackish solution to the problem of overriding C++ operator new/delete */
-extern const char *_leaker_file;
-extern const char *_leaker_func;
-extern unsigned long _leaker_line;
+extern LEAKER_TLS const char *_leaker_file;
+extern LEAKER_TLS const char *_leaker_func;
+extern LEAKER_TLS unsigned long _leaker_line;
 
 #define new (_leaker_file=__FILE__, _leaker_func=__func__, \
     _leaker_line=__LINE__) && 0 ? 0 : new
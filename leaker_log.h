@@ -0,0 +1,38 @@
+/*
+ * Leaker_log.h - record layout of the Leaker binary event log
+ *
+ * Shared by leaker.cpp, which writes the log (see _Leaker_Log() in
+ * leaker.h), and leaker_replay.cpp, which reads it back. Contains no
+ * allocation macros, so it is safe to include anywhere.
+ *
+ * This program is distributed under the terms of the GNU GPL version 2.
+ */
+
+#ifndef _LEAKER_LOG_H
+#define _LEAKER_LOG_H
+
+#define LEAKER_LOG_MAGIC    0x31474F4C4B41454CULL /* "LEAKLOG1" read as bytes */
+
+/* event types */
+#define LEAKER_LOG_HEADER   0   /* first record: addr = LEAKER_LOG_MAGIC,
+                                   size = sampling rate (0 if all tracked) */
+#define LEAKER_LOG_SITE     1   /* call site: site = its id, size = line,
+                                   addr = length of the file and function
+                                   names that follow, each ending in '\0' */
+#define LEAKER_LOG_ALLOC    2   /* malloc, calloc, new or new[]            */
+#define LEAKER_LOG_REALLOC  3   /* the new block of a realloc; the old one
+                                   gets a LEAKER_LOG_FREE just before      */
+#define LEAKER_LOG_FREE     4   /* free, delete or delete[], with the size
+                                   and site of the allocation              */
+
+/* one fixed-size record, written in the byte order of the machine */
+typedef struct
+{
+    unsigned long long time;    /* nanoseconds since the log was opened     */
+    unsigned long long addr;    /* address of the block                     */
+    unsigned long long size;    /* bytes requested, without the guard       */
+    unsigned int site;          /* id of the call site (LEAKER_LOG_SITE)    */
+    unsigned int type;          /* one of the LEAKER_LOG_ event types       */
+} _LEAKER_EVENT_T;
+
+#endif
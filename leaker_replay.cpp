@@ -0,0 +1,227 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include "leaker_log.h"
+using namespace std;
+
+// Offline analyzer for the binary event log written by leaker (_Leaker_Log()
+// in leaker.h). Replays every allocation and deallocation in order and prints:
+// - the totals of each event type
+// - live bytes and allocations over time, one row per time slice
+// - the peak of live bytes, when it happened and the top sites at that moment
+// - the leak set: blocks still live at the end of the log, grouped by site
+//
+// Usage: leaker_replay <log file> [rows]
+//   rows:      time slices in the timeline (default 20)
+//
+// Build: g++ -std=c++17 -O2 leaker_replay.cpp
+
+struct Site
+{
+	string file;
+	string func;
+	uint64_t line = 0;
+};
+
+struct Block
+{
+	uint64_t size;
+	uint32_t site;
+};
+
+struct Usage                                    // Live allocations of one site
+{
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+struct Slice                                    // One row of the timeline
+{
+	uint64_t end_bytes = 0;                     // Live bytes at the end of the slice
+	uint64_t end_count = 0;                     // Live allocations at the end of the slice
+	uint64_t max_bytes = 0;                     // Largest live bytes during the slice
+	bool seen = false;                          // Whether any event fell in the slice
+};
+
+static string site_name(const vector<Site>& sites, uint32_t id)
+{
+	if (id >= sites.size())
+		return "site #" + to_string(id);
+	return sites[id].file + ":" + sites[id].func + "():" + to_string(sites[id].line);
+}
+
+// Prints the sites of usage with the most bytes first, at most limit of them
+static void print_sites(const vector<Site>& sites, const unordered_map<uint32_t, Usage>& usage, size_t limit)
+{
+	vector<pair<uint32_t, Usage>> sorted(usage.begin(), usage.end());
+	sort(sorted.begin(), sorted.end(), [](const pair<uint32_t, Usage>& a, const pair<uint32_t, Usage>& b)
+	{
+		return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first < b.first;
+	});
+
+	cout << setw(12) << "bytes" << setw(10) << "count" << "  site\n";
+	for (size_t i = 0; i < sorted.size() && i < limit; i++)
+		cout << setw(12) << sorted[i].second.bytes << setw(10) << sorted[i].second.count
+			<< "  " << site_name(sites, sorted[i].first) << "\n";
+	if (sorted.size() > limit)
+		cout << "(" << sorted.size() - limit << " more sites)\n";
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "Usage: " << argv[0] << " <log file> [rows]\n";
+		return 1;
+	}
+	size_t rows = argc > 2 ? max(1ul, strtoul(argv[2], nullptr, 10)) : 20;
+
+	ifstream in(argv[1], ios::binary);
+	_LEAKER_EVENT_T event;
+	if (!in.read((char*)&event, sizeof(event)) || event.type != LEAKER_LOG_HEADER || event.addr != LEAKER_LOG_MAGIC)
+	{
+		cerr << argv[1] << ": not a leaker event log\n";
+		return 1;
+	}
+	uint64_t sample_rate = event.size;
+
+	// Read every event first, so the timeline can be split evenly over the run.
+	// A threadsafe leaker logs a site once per shard; those ids are merged here.
+	vector<Site> sites;
+	vector<uint32_t> merged;                    // Logged site id -> index in sites
+	unordered_map<string, uint32_t> by_name;
+	vector<_LEAKER_EVENT_T> events;
+	while (in.read((char*)&event, sizeof(event)))
+	{
+		if (event.type != LEAKER_LOG_SITE)
+		{
+			if (event.site < merged.size())
+				event.site = merged[event.site];
+			events.push_back(event);
+			continue;
+		}
+
+		string names(event.addr, '\0');
+		if (!in.read(&names[0], names.size()))
+			break;
+
+		Site site;
+		site.file = names.c_str();
+		site.func = names.c_str() + site.file.size() + 1;
+		site.line = event.size;
+
+		auto found = by_name.emplace(site.file + ":" + site.func + ":" + to_string(site.line), (uint32_t)sites.size());
+		if (found.second)
+			sites.push_back(site);
+		if (merged.size() <= event.site)
+			merged.resize(event.site + 1);
+		merged[event.site] = found.first->second;
+	}
+
+	unordered_map<uint64_t, Block> live;
+	uint64_t live_bytes = 0, allocs = 0, reallocs = 0, frees = 0, unmatched = 0, allocated_bytes = 0;
+	uint64_t peak_bytes = 0, peak_count = 0, peak_time = 0;
+	size_t peak_event = 0;
+	uint64_t end_time = events.empty() ? 0 : events.back().time;
+	vector<Slice> timeline(rows);
+
+	for (size_t i = 0; i < events.size(); i++)
+	{
+		const _LEAKER_EVENT_T& e = events[i];
+
+		if (e.type == LEAKER_LOG_FREE)
+		{
+			auto it = live.find(e.addr);
+			if (it == live.end())
+				unmatched++;                    // Allocated before the log was opened
+			else
+			{
+				live_bytes -= it->second.size;
+				live.erase(it);
+			}
+			frees++;
+		}
+		else
+		{
+			live[e.addr] = Block{ e.size, e.site };
+			live_bytes += e.size;
+			allocated_bytes += e.size;
+			(e.type == LEAKER_LOG_REALLOC ? reallocs : allocs)++;
+
+			if (live_bytes > peak_bytes)
+			{
+				peak_bytes = live_bytes;
+				peak_count = live.size();
+				peak_time = e.time;
+				peak_event = i;
+			}
+		}
+
+		Slice& slice = timeline[end_time ? min<uint64_t>(rows - 1, e.time * rows / end_time) : 0];
+		slice.end_bytes = live_bytes;
+		slice.end_count = live.size();
+		slice.max_bytes = max(slice.max_bytes, live_bytes);
+		slice.seen = true;
+	}
+
+	cout << "Leaker replay of " << argv[1] << ":\n";
+	cout << allocs << " allocations, " << reallocs << " reallocations, " << frees << " deallocations ("
+		<< unmatched << " of blocks allocated before the log), " << allocated_bytes << " bytes allocated in "
+		<< fixed << setprecision(3) << end_time / 1e9 << " s.\n";
+	if (sample_rate)
+		cout << "Sampling 1 in " << sample_rate << " bytes: only sampled allocations were logged.\n";
+
+	// Timeline. Slices without events carry the state of the one before.
+	cout << "\n" << setw(12) << "until (s)" << setw(14) << "live bytes" << setw(10) << "live" << setw(14) << "max bytes" << "\n";
+	Slice last;
+	for (size_t i = 0; i < rows; i++)
+	{
+		if (!timeline[i].seen)
+			timeline[i] = Slice{ last.end_bytes, last.end_count, last.end_bytes, false };
+		last = timeline[i];
+		cout << setw(12) << setprecision(3) << (end_time * (i + 1) / rows) / 1e9 << setw(14) << last.end_bytes
+			<< setw(10) << last.end_count << setw(14) << last.max_bytes << "\n";
+	}
+
+	// Replay once more up to the peak to see which sites held the memory then
+	cout << "\nPeak: " << peak_bytes << " bytes in " << peak_count << " allocations at "
+		<< setprecision(6) << peak_time / 1e9 << " s (event " << peak_event << ").\n";
+	if (peak_bytes)
+	{
+		unordered_map<uint64_t, Block> at_peak;
+		unordered_map<uint32_t, Usage> usage;
+		for (size_t i = 0; i <= peak_event; i++)
+		{
+			if (events[i].type == LEAKER_LOG_FREE)
+				at_peak.erase(events[i].addr);
+			else
+				at_peak[events[i].addr] = Block{ events[i].size, events[i].site };
+		}
+		for (const auto& block : at_peak)
+		{
+			usage[block.second.site].count++;
+			usage[block.second.site].bytes += block.second.size;
+		}
+		print_sites(sites, usage, 10);
+	}
+
+	cout << "\nLeaks: " << live_bytes << " bytes in " << live.size() << " allocations live at the end of the log.\n";
+	if (!live.empty())
+	{
+		unordered_map<uint32_t, Usage> usage;
+		for (const auto& block : live)
+		{
+			usage[block.second.site].count++;
+			usage[block.second.site].bytes += block.second.size;
+		}
+		print_sites(sites, usage, (size_t)-1);
+	}
+
+	return 0;
+}